@@ -2,365 +2,228 @@
 #include "Common\MeshCache.h"
 
 #include "tiny_obj_loader.h"
+#include "..\OctreeVoxelizerCmd\LinearOctree.h"
+#include "..\OctreeVoxelizerCmd\ObjVoxelStream.h"
+#include "..\OctreeVoxelizerCmd\BinaryTree.h"
+#include "..\OctreeVoxelizerCmd\TriangleVoxelizer.h"
+#include "..\OctreeVoxelizerCmd\VoxelMesher.h"
 
 using namespace DisplayComplexity;
 using namespace DirectX;
 
 int granularity = 30;
 int depth = 30;
+int octreeDepth = 0;            // > 0 fills the mesh with the octree's voxel boxes
+bool solidVoxelization = false; // voxelize the mesh interior, not just its vertices
+bool triangleVoxelization = false;     // voxelize every cell a triangle overlaps, not just the vertices
+bool conservativeVoxelization = false; // with triangleVoxelization, also the cells a triangle only touches
+bool streamObj = false;         // parse straight into the octree, keeping only the positions
+
+MeshCache::MeshCache(size_t budget) :
+    budget(budget)
+{
+}
 
-struct BoundingBox3D {
-    XMFLOAT3 Min, Max;
-
-    BoundingBox3D()
-        : Min(FLT_MAX, FLT_MAX, FLT_MAX),
-        Max(-FLT_MAX, -FLT_MAX, -FLT_MAX) {}
-
-    BoundingBox3D(const XMFLOAT3& Min, const XMFLOAT3& Max)
-        : Min(Min), Max(Max) {}
-
-    void AddPoint(const XMFLOAT3& p) {
-        Min.x = p.x < Min.x ? p.x : Min.x;
-        Min.y = p.y < Min.y ? p.y : Min.y;
-        Min.z = p.z < Min.z ? p.z : Min.z;
-
-        Max.x = p.x > Max.x ? p.x : Max.x;
-        Max.y = p.y > Max.y ? p.y : Max.y;
-        Max.z = p.z > Max.z ? p.z : Max.z;
-    }
+MeshCache::~MeshCache()
+{
+    // Loads still running store their mesh into the map when done.
+    std::vector<concurrency::task<MeshHandle>> loading;
+    {
+        std::unique_lock<std::shared_timed_mutex> lock(meshesMutex);
 
-    bool IncludePoint(const XMFLOAT3& p) {
-        return Min.x < p.x && Min.y < p.y && Min.z < p.z
-            && Max.x > p.x && Max.y > p.y && Max.z > p.z;
+        for ( auto it = meshes.begin();
+            it != meshes.end(); ++it )
+        {
+            if ( it->second.mesh == nullptr )
+                loading.push_back(it->second.load);
+        }
     }
-};
-
-struct VoxelNode {
-    std::vector<int> position; // size of position is depth. Root is empty
-    BoundingBox3D* boundingBox = nullptr;
 
-    VoxelNode* parent = nullptr;
-    VoxelNode* children[8];
-    bool isCompleteSubtree = false;
-    bool isLeaf = false;
-
-    VoxelNode() {
-        memset(children, 0, sizeof(VoxelNode*) * 8);
+    // A failed load has already dropped its entry; its error has nowhere to go.
+    for ( auto& load : loading )
+    {
+        try
+        {
+            load.wait();
+        }
+        catch ( ... )
+        {
+        }
     }
-};
 
-struct VoxelOctree {
-    VoxelNode* rootNode = nullptr;
-    std::vector<const BoundingBox3D*> boxGeometries;
-};
-
-void createSuboctree(VoxelNode** parent, const std::vector<XMFLOAT3*>& vertices, const BoundingBox3D& boundingBox, int depth) {
-    assert(parent != nullptr && *parent != nullptr);
-    XMVECTOR mid, Min, Max;
-    Min = XMLoadFloat3(&boundingBox.Min);
-    Max = XMLoadFloat3(&boundingBox.Max);
-    mid = (Min + Max) * 0.5f;
+    meshes.clear();
+}
 
-    auto halfLength = Max - mid;
-    auto halfLengthX = XMVectorSet(XMVectorGetX(halfLength), 0, 0, 0);
-    auto halfLengthY = XMVectorSet(0, XMVectorGetY(halfLength), 0, 0);
-    auto halfLengthZ = XMVectorSet(0, 0, XMVectorGetZ(halfLength), 0);
+concurrency::task<MeshHandle> MeshCache::GetMeshAsync(const std::string& path, const std::string& base_dir)
+{
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(meshesMutex);
 
-    BoundingBox3D childrensBoundingBox[8];
+        auto it = meshes.find(path);
+        if ( it != meshes.end() )
+        {
+            Entry& entry = it->second;
+            entry.lastUse = ++useClock;
+            ++hits;
 
-    XMStoreFloat3(&childrensBoundingBox[0].Min, Min + halfLengthZ);
-    XMStoreFloat3(&childrensBoundingBox[0].Max, mid + halfLengthZ);
+            return entry.mesh != nullptr ? concurrency::task_from_result(entry.mesh) : entry.load;
+        }
+    }
 
-    XMStoreFloat3(&childrensBoundingBox[1].Min, Min - halfLengthY);
-    XMStoreFloat3(&childrensBoundingBox[1].Max, Max - halfLengthY);
+    std::unique_lock<std::shared_timed_mutex> lock(meshesMutex);
 
-    XMStoreFloat3(&childrensBoundingBox[2].Min, Min + halfLengthX);
-    XMStoreFloat3(&childrensBoundingBox[2].Max, mid + halfLengthX);
+    // Another thread may have started the load between the two locks.
+    auto it = meshes.find(path);
+    if ( it != meshes.end() )
+    {
+        Entry& entry = it->second;
+        entry.lastUse = ++useClock;
+        ++hits;
 
-    XMStoreFloat3(&childrensBoundingBox[3].Min, Min);
-    XMStoreFloat3(&childrensBoundingBox[3].Max, mid);
+        return entry.mesh != nullptr ? concurrency::task_from_result(entry.mesh) : entry.load;
+    }
 
-    XMStoreFloat3(&childrensBoundingBox[4].Min, mid - halfLengthX);
-    XMStoreFloat3(&childrensBoundingBox[4].Max, Max - halfLengthX);
+    ++misses;
 
-    XMStoreFloat3(&childrensBoundingBox[5].Min, mid);
-    XMStoreFloat3(&childrensBoundingBox[5].Max, Max);
+    Entry& entry = meshes[path];
+    entry.lastUse = ++useClock;
+    entry.load = concurrency::create_task(entry.loaded);
 
-    XMStoreFloat3(&childrensBoundingBox[6].Min, mid - halfLengthZ);
-    XMStoreFloat3(&childrensBoundingBox[6].Max, Max - halfLengthZ);
+    // The entry is only evicted once loaded, so the continuation can keep it.
+    const concurrency::task_completion_event<MeshHandle> loaded = entry.loaded;
+    const concurrency::task<MeshHandle> result = entry.load;
+    const std::wstring directory = diskCacheDirectory;
 
-    XMStoreFloat3(&childrensBoundingBox[7].Min, Min + halfLengthY);
-    XMStoreFloat3(&childrensBoundingBox[7].Max, mid + halfLengthY);
+    // The load starts once the lock is released: a load that is done before
+    // its continuation is attached may run the continuation on this thread,
+    // which takes the lock again.
+    lock.unlock();
 
-    for (int i = 0; i < 8; ++i) {
-        std::vector<XMFLOAT3*> subvertices;
+    concurrency::create_task([this, path, base_dir, directory] ()
+    {
+        return LoadMesh(path, base_dir, directory);
+    }).then([this, path, &entry, loaded] (concurrency::task<MeshHandle> load)
+    {
+        MeshHandle mesh;
 
-        for (auto* vertex : vertices) {
-            if (childrensBoundingBox[i].IncludePoint(*vertex)) {
-                subvertices.push_back(vertex);
+        try
+        {
+            mesh = load.get();
+        }
+        catch ( ... )
+        {
+            // Callers waiting on this load get the error; the next request
+            // for the path starts a new load.
+            {
+                std::unique_lock<std::shared_timed_mutex> lock(meshesMutex);
+                meshes.erase(path);
             }
+
+            loaded.set_exception(std::current_exception());
+            return;
         }
 
-        if (subvertices.size() > 0) {
-            (*parent)->children[i] = new VoxelNode();
-            (*parent)->children[i]->parent = *parent;
-            (*parent)->children[i]->position = (*parent)->position;
-            (*parent)->children[i]->position.push_back(i);
+        {
+            std::unique_lock<std::shared_timed_mutex> lock(meshesMutex);
 
-            BoundingBox3D* pChildBoundingBox = new BoundingBox3D();
-            *pChildBoundingBox = childrensBoundingBox[i];
-            (*parent)->children[i]->boundingBox = pChildBoundingBox;
+            entry.mesh = mesh;
+            entry.bytes = mesh->SizeInBytes();
+            entry.load = concurrency::task<MeshHandle>();
+            bytes += entry.bytes;
 
-            if (depth - 1 > 0) {
-                createSuboctree(&(*parent)->children[i], subvertices, childrensBoundingBox[i], depth - 1);
-            }
-            else {
-                (*parent)->children[i]->isLeaf = true;
-            }
+            EvictUnused();
         }
-    }
-
-    int isFull = 0;
 
-    for (int i = 0; i < 8; ++i) {
-        if (parent && (*parent)->children[i]
-            && ((*parent)->children[i]->isLeaf || (*parent)->children[i]->isCompleteSubtree)) {
-            isFull++;
-        }
-    }
+        // Outside the lock too, since waiting continuations may run inline.
+        loaded.set(mesh);
+    });
 
-    if (isFull == 8) {
-        (*parent)->isCompleteSubtree = true;
-    }
+    return result;
 }
 
-void BuildOctreeGeometry(VoxelOctree* octree, VoxelNode* parent)
+MeshHandle MeshCache::GetMesh(const std::string& path, const std::string& base_dir)
 {
-    if (!octree)
-        return;
-
-    if (parent->isCompleteSubtree) {
-        octree->boxGeometries.push_back(parent->boundingBox);
-    }
-    else {
-        for (int i = 0; i < 8; ++i) {
-            auto* child = parent->children[i];
-
-            if (child) {
-                if (child->isLeaf) {
-                    octree->boxGeometries.push_back(child->boundingBox);
-                }
-                else {
-                    BuildOctreeGeometry(octree, parent->children[i]);
-                }
-            }
-        }
-    }
+    return GetMeshAsync(path, base_dir).get();
 }
 
-VoxelOctree* createOctree(const std::vector<XMFLOAT3*>& vertices, int depth) {
-    VoxelOctree* voxelOctree = new VoxelOctree();
-    voxelOctree->rootNode = new VoxelNode();
-
-    BoundingBox3D *bb = new BoundingBox3D();
-    for (auto* vertex : vertices) {
-        bb->AddPoint(*vertex);
-    }
-    voxelOctree->rootNode->boundingBox = bb;
-
-    createSuboctree(&voxelOctree->rootNode, vertices, *bb, depth);
+void MeshCache::SetBudget(size_t bytes)
+{
+    std::unique_lock<std::shared_timed_mutex> lock(meshesMutex);
 
-    return voxelOctree;
+    budget = bytes;
+    EvictUnused();
 }
 
-MeshCache::~MeshCache()
+void MeshCache::SetDiskCacheDirectory(const std::wstring& directory)
 {
-    for ( auto it = meshes.begin();
-        it != meshes.end(); ++it )
-    {
-        if ( it->second != nullptr )
-        {
-            delete it->second;
-            it->second = nullptr;
-        }
-    }
+    std::unique_lock<std::shared_timed_mutex> lock(meshesMutex);
 
-    meshes.clear();
+    diskCacheDirectory = directory;
 }
 
-struct BinaryTree;
-struct BinaryTreeNode;
-
-struct BinaryTreeNode {
-public:
-	std::vector<XMFLOAT3*> vertices;
-	BinaryTreeNode * left = nullptr, *right = nullptr;
-	BinaryTree* tree = nullptr;;
-};
-
-struct BinaryTree {
-public:
-	BinaryTreeNode * rootNode = nullptr;
-	std::vector<BoundingBox3D> boundingBoxes;
-};
-
-void BuildBinarySubtree(BinaryTreeNode* parent, BoundingBox3D boundingBox, int depth)
+void MeshCache::Trim()
 {
-	for (int i = 0; i < parent->vertices.size(); ++i) {
-		boundingBox.AddPoint(*parent->vertices[i]);
-	}
-
-	float widths[3] = {
-		boundingBox.Max.x - boundingBox.Min.x,
-		boundingBox.Max.y - boundingBox.Min.y,
-		boundingBox.Max.z - boundingBox.Min.z
-	};
-
-	float mid[] = {
-		boundingBox.Min.x + widths[0] * 0.5f,
-		boundingBox.Min.y + widths[1] * 0.5f,
-		boundingBox.Min.z + widths[2] * 0.5f
-	};
-
-	int orderedIndices[3] = { 0 };
-	float minValue = FLT_MAX, maxValue = -FLT_MAX;
-
-	for (int i = 0; i < 3; ++i) {
-		if (widths[i] > maxValue) {
-			maxValue = widths[i];
-			orderedIndices[0] = i;
-		}
-		if (widths[i] < minValue) {
-			minValue = widths[i];
-			orderedIndices[2] = i;
-		}
-	}
-
-	for (int i = 0; i < 3; ++i) {
-		if (i != orderedIndices[0] && i != orderedIndices[2]) {
-			orderedIndices[1] = i;
-			break;
-		}
-	}
-
-	int currentIndex = 0;
-FAILED:
-	int maxIndices;
-	maxIndices = orderedIndices[currentIndex];
-
-	for (int i = 0; i < parent->vertices.size(); ++i) {
-		const float* pVertices = (const float*)parent->vertices[i];
-
-		if (pVertices[maxIndices] > mid[maxIndices]) {
-			if (!parent->left) {
-				parent->left = new BinaryTreeNode();
-				parent->left->tree = parent->tree;
-			}
+    std::unique_lock<std::shared_timed_mutex> lock(meshesMutex);
 
-			parent->left->vertices.push_back(parent->vertices[i]);
-		}
-		else {
-			if (!parent->right) {
-				parent->right = new BinaryTreeNode();
-				parent->right->tree = parent->tree;
-			}
-
-			parent->right->vertices.push_back(parent->vertices[i]);
-		}
-	}
-
-	if (!parent->left || !parent->right) {
-		if (parent->left)
-			parent->left->vertices.clear();
-		if (parent->right)
-			parent->right->vertices.clear();
-
-		if (++currentIndex < 3)
-			goto FAILED;
-		else {
-			assert(false);
-		}
-	}
-
-	BoundingBox3D leftBB;
-
-	for (int i = 0; i < parent->left->vertices.size(); ++i) {
-		leftBB.AddPoint(*parent->left->vertices[i]);
-	}
-
-	BoundingBox3D rightBB;
-
-	for (int i = 0; i < parent->right->vertices.size(); ++i) {
-		rightBB.AddPoint(*parent->right->vertices[i]);
-	}
-
-	if (parent->left && parent->left->vertices.size() > granularity && depth - 1 > 0) {
-		BuildBinarySubtree(parent->left, leftBB, depth - 1);
-	}
-	else if (parent->left) {
-		parent->tree->boundingBoxes.push_back(leftBB);
-	}
-
-	if (parent->right && parent->right->vertices.size() > granularity && depth - 1 > 0) {
-		BuildBinarySubtree(parent->right, rightBB, depth - 1);
-	}
-	else if (parent->right) {
-		parent->tree->boundingBoxes.push_back(rightBB);
-	}
+    EvictUnused();
 }
 
-BinaryTree* BuildBinaryTree(std::vector<XMFLOAT3*> vertices, int depth)
+MeshCacheStats MeshCache::GetStats()
 {
-	BinaryTree* tree = new BinaryTree();
-
-	BoundingBox3D boundingBox;
-
-	for (int i = 0; i < vertices.size(); ++i) {
-		boundingBox.AddPoint(*vertices[i]);
-	}
+    std::shared_lock<std::shared_timed_mutex> lock(meshesMutex);
 
-	XMFLOAT3 median;
-	median.x = (boundingBox.Max.x + boundingBox.Min.x) * 0.5f;
-	median.y = (boundingBox.Max.y + boundingBox.Min.y) * 0.5f;
-	median.z = (boundingBox.Max.z + boundingBox.Min.z) * 0.5f;
+    MeshCacheStats stats = { hits, misses, diskHits, evictions, meshes.size(), bytes, budget };
+    return stats;
+}
 
-	tree->rootNode = new BinaryTreeNode();
-	tree->rootNode->vertices = vertices;
-	tree->rootNode->tree = tree;
+void MeshCache::EvictUnused()
+{
+    while ( bytes > budget )
+    {
+        // Only the entry holds an unused mesh's handle, and no other thread
+        // can copy it without the lock.
+        auto victim = meshes.end();
 
-	for (int i = 0; i < vertices.size(); ++i) {
-		vertices[i]->x -= median.x;
-		vertices[i]->y -= median.y;
-		vertices[i]->z -= median.z;
-	}
+        for ( auto it = meshes.begin(); it != meshes.end(); ++it )
+        {
+            const Entry& entry = it->second;
 
-	BuildBinarySubtree(tree->rootNode, boundingBox, depth);
+            if ( entry.mesh == nullptr || entry.mesh.use_count() > 1 )
+                continue;
 
-	for (auto& bb : tree->boundingBoxes) {
-		bb.Max.x += median.x;
-		bb.Max.y += median.y;
-		bb.Max.z += median.z;
+            if ( victim == meshes.end() || entry.lastUse < victim->second.lastUse )
+                victim = it;
+        }
 
-		bb.Min.x += median.x;
-		bb.Min.y += median.y;
-		bb.Min.z += median.z;
-	}
+        if ( victim == meshes.end() )
+            break;
 
-	return tree;
+        bytes -= victim->second.bytes;
+        meshes.erase(victim);
+        ++evictions;
+    }
 }
 
-
-Mesh* MeshCache::GetMesh(const std::string& path, const std::string& base_dir)
+// Everything a built mesh depends on besides its source file.
+static uint64_t MeshOptionsHash()
 {
-    if ( meshes.find(path) != meshes.end() )
-        return meshes[path];
+    const int options[] = { octreeDepth, solidVoxelization ? 1 : 0, streamObj ? 1 : 0, triangleVoxelization ? 1 : 0, conservativeVoxelization ? 1 : 0 };
+    return HashBytes(options, sizeof(options), 0);
+}
 
+// Parses the OBJ and fills the vectors with the octree's voxel mesh.
+static MeshHandle BuildMesh(const std::string& path, const std::string& base_dir)
+{
     tinyobj::attrib_t attrib;
     std::vector<tinyobj::shape_t> shapes;
     std::vector<tinyobj::material_t> materials;
     std::string err;
 
-    bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, ".\\Assets\\bunny.obj", ".\\Assets\\", false);
+    ObjVoxelStream stream(octreeDepth > 0 && (solidVoxelization || triangleVoxelization));
+
+    bool ret = streamObj ?
+        StreamObjFile<tinyobj::callback_t>(path.c_str(), stream, &err) :
+        tinyobj::LoadObj(&attrib, &shapes, &materials, &err, path.c_str(), base_dir.c_str(), true);
 
     if ( !err.empty() )
     {
@@ -372,7 +235,12 @@ Mesh* MeshCache::GetMesh(const std::string& path, const std::string& base_dir)
 		OutputDebugStringA("Failed to load/parse .obj.\n");
 	}
 
-	Mesh* mesh = new Mesh();
+	if ( stream.droppedTriangles > 0 )
+	{
+		OutputDebugStringA(("Dropped " + std::to_string(stream.droppedTriangles) + " triangles with invalid indices.\n").c_str());
+	}
+
+	MeshHandle mesh = std::make_shared<Mesh>();
 
 	/*
 	int N = 1;
@@ -406,10 +274,61 @@ Mesh* MeshCache::GetMesh(const std::string& path, const std::string& base_dir)
 	}
 	meshes[path] = mesh;
 	*/
+    std::vector<float>& positions = streamObj ? stream.positions : attrib.vertices;
     std::vector<XMFLOAT3*> vertices;
 
-    for (int i = 0; i < attrib.vertices.size() / 3; ++i) {
-        vertices.push_back(reinterpret_cast<XMFLOAT3*>(attrib.vertices.data() + 3 * i));
+    // Streamed, the pointers wait until the octree is built and freed.
+    if ( !streamObj )
+    {
+        for (int i = 0; i < positions.size() / 3; ++i) {
+            vertices.push_back(reinterpret_cast<XMFLOAT3*>(positions.data() + 3 * i));
+        }
+    }
+
+    // Before the binary tree below, which recenters the vertices in place.
+    if (octreeDepth > 0)
+    {
+        LinearOctree* voxelOctree;
+
+        if ( streamObj )
+        {
+            if ( solidVoxelization )
+                voxelOctree = createSolidLinearOctree(stream, octreeDepth);
+            else if ( triangleVoxelization )
+                voxelOctree = createLinearOctreeFromTriangles(stream, octreeDepth, conservativeVoxelization);
+            else
+                voxelOctree = createLinearOctree(stream, octreeDepth);
+        }
+        else if (solidVoxelization || triangleVoxelization)
+        {
+            std::vector<unsigned int> indices;
+            AppendTriangleIndices(shapes, indices);
+
+            // The solid octree already holds the surface cells.
+            voxelOctree = solidVoxelization ?
+                createSolidLinearOctreeFromTriangles(attrib.vertices, indices, octreeDepth) :
+                createLinearOctreeFromTriangles(attrib.vertices, indices, octreeDepth, conservativeVoxelization);
+        }
+        else
+        {
+            voxelOctree = createLinearOctree(vertices, octreeDepth);
+        }
+
+        // Hidden faces culled and coplanar faces merged, instead of a box per voxel.
+        VoxelMesh voxelMesh;
+        BuildLinearOctreeMesh(voxelOctree, voxelMesh);
+        delete voxelOctree;
+
+        const unsigned int index = static_cast<unsigned int>(mesh->meshVertices.size());
+
+        for (const auto& vertex : voxelMesh.vertices) {
+            mesh->meshVertices.push_back(VertexPositionColor(vertex, XMFLOAT3(1, 1, 1)));
+        }
+        for (unsigned int voxelIndex : voxelMesh.indices) {
+            mesh->meshIndices.push_back(index + voxelIndex);
+        }
+
+        OutputDebugStringA(("Index:" + std::to_string(voxelMesh.vertices.size()) + "\n").c_str());
     }
 
 	LARGE_INTEGER lastTime, currentTime, frequency;
@@ -417,12 +336,21 @@ Mesh* MeshCache::GetMesh(const std::string& path, const std::string& base_dir)
 
 	static const unsigned TicksPerSecond = 10'000'000;
 
+	if ( streamObj )
+	{
+		for (int i = 0; i < positions.size() / 3; ++i) {
+			vertices.push_back(reinterpret_cast<XMFLOAT3*>(positions.data() + 3 * i));
+		}
+	}
+
 	QueryPerformanceCounter(&lastTime);
 
-	BuildBinaryTree(vertices, depth);
+	BinaryTree* tree = BuildBinaryTreeParallel(vertices, depth, granularity);
 
 	QueryPerformanceCounter(&currentTime);
 
+	delete tree;
+
 	uint64 timeDelta = currentTime.QuadPart - lastTime.QuadPart;
 
 	timeDelta *= TicksPerSecond;
@@ -433,55 +361,31 @@ Mesh* MeshCache::GetMesh(const std::string& path, const std::string& base_dir)
 	OutputDebugStringA(std::to_string(dt).c_str());
 	OutputDebugStringA("\n");
 
+	mesh->UseVectors();
 
+	return mesh;
+}
 
-	/*
-
-    auto* voxelOctree = createOctree(vertices, 5);
-
-    BuildOctreeGeometry(voxelOctree, voxelOctree->rootNode);
+MeshHandle MeshCache::LoadMesh(const std::string& path, const std::string& base_dir, const std::wstring& diskCacheDirectory)
+{
+    MeshBlobKey key;
+    const bool useDiskCache = !diskCacheDirectory.empty() && HashMeshSource(path, MeshOptionsHash(), key);
+    const std::wstring blobFilename = useDiskCache ? MeshBlobFilename(diskCacheDirectory, path, key.optionsHash) : std::wstring();
 
+    if ( useDiskCache )
     {
-        unsigned short index = 0;
-
-        for (const auto* leafNodeBox : voxelOctree->boxGeometries) {
-            auto &Min = leafNodeBox->Min;
-            auto &Max = leafNodeBox->Max;
-
-            mesh->meshVertices.insert(mesh->meshVertices.end(),
-                { VertexPositionColor(XMFLOAT3(Min.x, Min.y, Min.z), XMFLOAT3(1, 1, 1)),
-                VertexPositionColor(XMFLOAT3(Min.x, Min.y, Max.z), XMFLOAT3(1, 1, 1)),
-                VertexPositionColor(XMFLOAT3(Min.x, Max.y, Min.z), XMFLOAT3(1, 1, 1)),
-                VertexPositionColor(XMFLOAT3(Min.x, Max.y, Max.z), XMFLOAT3(1, 1, 1)),
-                VertexPositionColor(XMFLOAT3(Max.x, Min.y, Min.z), XMFLOAT3(1, 1, 1)),
-                VertexPositionColor(XMFLOAT3(Max.x, Min.y, Max.z), XMFLOAT3(1, 1, 1)),
-                VertexPositionColor(XMFLOAT3(Max.x, Max.y, Min.z), XMFLOAT3(1, 1, 1)),
-                VertexPositionColor(XMFLOAT3(Max.x, Max.y, Max.z), XMFLOAT3(1, 1, 1)) });
-
-            mesh->meshIndices.insert(mesh->meshIndices.end(),
-                {
-                    unsigned short(index + 2),unsigned short(index + 0),unsigned short(index + 1), // -x
-                    unsigned short(index + 2),unsigned short(index + 1),unsigned short(index + 3),
-                    unsigned short(index + 6),unsigned short(index + 5),unsigned short(index + 4), // +x
-                    unsigned short(index + 6),unsigned short(index + 7),unsigned short(index + 5),
-                    unsigned short(index + 0),unsigned short(index + 5),unsigned short(index + 1), // -y
-                    unsigned short(index + 0),unsigned short(index + 4),unsigned short(index + 5),
-                    unsigned short(index + 2),unsigned short(index + 7),unsigned short(index + 6), // +y
-                    unsigned short(index + 2),unsigned short(index + 3),unsigned short(index + 7),
-                    unsigned short(index + 0),unsigned short(index + 6),unsigned short(index + 4), // -z
-                    unsigned short(index + 0),unsigned short(index + 2),unsigned short(index + 6),
-                    unsigned short(index + 1),unsigned short(index + 7),unsigned short(index + 3), // +z
-                    unsigned short(index + 1),unsigned short(index + 5),unsigned short(index + 7),
-                });
-
-            index += 8;
+        MeshHandle cached = LoadMeshBlob(blobFilename, key);
+        if ( cached != nullptr )
+        {
+            ++diskHits;
+            return cached;
         }
-
-        OutputDebugStringA(("Index:" + std::to_string(index) + "\n").c_str());
     }
 
-    meshes[path] = mesh;
-	*/
+    MeshHandle mesh = BuildMesh(path, base_dir);
 
-	return mesh;
-}
\ No newline at end of file
+    if ( useDiskCache )
+        StoreMeshBlob(blobFilename, key, *mesh);
+
+    return mesh;
+}
@@ -2,7 +2,13 @@
 
 #include "Content\ShaderStructures.h"
 #include "Content\Singleton.h"
+#include "Common\MeshDiskCache.h"
+#include <atomic>
 #include <map>
+#include <memory>
+#include <ppltasks.h>
+#include <shared_mutex>
+#include <string>
 #include <vector>
 
 namespace DisplayComplexity
@@ -10,17 +16,104 @@ namespace DisplayComplexity
     class Mesh
     {
     public:
+        // Filled when the mesh is built, empty when it is mapped from the disk cache.
         std::vector<VertexPositionColor> meshVertices;
         std::vector<unsigned int> meshIndices;
+
+        // What to draw: the vectors above, or the arrays of a mapped blob.
+        const VertexPositionColor* vertices = nullptr;
+        size_t vertexCount = 0;
+        const unsigned int* indices = nullptr;
+        size_t indexCount = 0;
+
+        std::shared_ptr<MappedFile> mappedFile;
+
+        // Points vertices and indices at the vectors, once they are filled.
+        void UseVectors()
+        {
+            vertices = meshVertices.data();
+            vertexCount = meshVertices.size();
+            indices = meshIndices.data();
+            indexCount = meshIndices.size();
+        }
+
+        size_t SizeInBytes() const { return vertexCount * sizeof(VertexPositionColor) + indexCount * sizeof(unsigned int); }
     };
 
+    // A mesh stays loaded while any handle to it is alive.
+    typedef std::shared_ptr<Mesh> MeshHandle;
+
+    struct MeshCacheStats
+    {
+        uint64_t hits;       // requests for a mesh loaded or loading
+        uint64_t misses;     // requests that started a load
+        uint64_t diskHits;   // loads mapped from the disk cache instead of parsed
+        uint64_t evictions;
+        size_t meshCount;
+        size_t bytes;        // of the loaded meshes, Mesh::SizeInBytes
+        size_t budget;
+    };
+
+    // Meshes by path, each parsed and voxelized once on the PPL thread pool.
+    // With a disk cache directory, built meshes are also written there as
+    // binary blobs, and later runs map those instead of parsing the source.
+    // Past the byte budget, the least recently requested meshes that no
+    // handle refers to are evicted; meshes in use stay, even over budget.
     class MeshCache : public Singleton<MeshCache>
     {
     public:
-        std::map<std::string, Mesh*> meshes;
+        static const size_t DefaultBudget = 256 << 20;
+
+        explicit MeshCache(size_t budget = DefaultBudget);
 
-        Mesh* GetMesh(const std::string& path, const std::string& base_dir);
+        // The first request for a path starts its load; every later or
+        // concurrent request gets the same mesh, so the file is read once
+        // while it stays cached. If the load throws, its requests get the
+        // error and the next request starts over.
+        concurrency::task<MeshHandle> GetMeshAsync(const std::string& path, const std::string& base_dir);
+
+        // Waits for GetMeshAsync. Blocking is not allowed on the UI thread.
+        MeshHandle GetMesh(const std::string& path, const std::string& base_dir);
+
+        // Evicts right away if the cache is over the new budget. Released
+        // handles are evicted on the next load or Trim.
+        void SetBudget(size_t bytes);
+        void Trim();
+
+        // Empty turns the disk cache off, as it is by default. Applies to
+        // loads started afterwards.
+        void SetDiskCacheDirectory(const std::wstring& directory);
+
+        MeshCacheStats GetStats();
 
         ~MeshCache();
+
+    private:
+        struct Entry
+        {
+            concurrency::task_completion_event<MeshHandle> loaded; // set outside meshesMutex
+            concurrency::task<MeshHandle> load; // of loaded, until the mesh is loaded
+            MeshHandle mesh;
+            size_t bytes = 0;
+            std::atomic<uint64_t> lastUse{ 0 };
+        };
+
+        // Hits only read the map, under a shared lock, and stamp lastUse.
+        std::map<std::string, Entry> meshes;
+        std::shared_timed_mutex meshesMutex;
+
+        size_t budget;
+        size_t bytes = 0;
+        std::atomic<uint64_t> useClock{ 0 };
+        std::atomic<uint64_t> hits{ 0 };
+        std::atomic<uint64_t> misses{ 0 };
+        std::atomic<uint64_t> diskHits{ 0 };
+        std::wstring diskCacheDirectory;
+        std::atomic<uint64_t> evictions{ 0 };
+
+        // Called with meshesMutex held exclusively.
+        void EvictUnused();
+
+        MeshHandle LoadMesh(const std::string& path, const std::string& base_dir, const std::wstring& diskCacheDirectory);
     };
-}
\ No newline at end of file
+}
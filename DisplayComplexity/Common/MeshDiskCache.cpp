@@ -0,0 +1,201 @@
+#include "pch.h"
+#include "Common\MeshDiskCache.h"
+
+#include "Common\MeshCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace DisplayComplexity;
+
+static const char MeshBlobMagic[8] = { 'M', 'E', 'S', 'H', 'B', 'L', 'O', 'B' };
+
+// Bump whenever the layout below or the way meshes are built changes.
+static const uint32_t MeshBlobVersion = 1;
+
+// Followed by vertexCount vertices and indexCount indices, little-endian.
+struct MeshBlobHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t vertexSize;
+    MeshBlobKey key;
+    uint64_t vertexCount;
+    uint64_t indexCount;
+};
+
+static_assert(sizeof(MeshBlobHeader) % 8 == 0, "Vertices must start 8-byte aligned in the mapping.");
+
+// Blocks are a multiple of 8 bytes, so only the last one has a partial word.
+static const size_t HashBlockSize = 1 << 20;
+
+std::shared_ptr<MappedFile> MappedFile::Open(const std::wstring& filename)
+{
+    std::shared_ptr<MappedFile> mapped(new MappedFile());
+
+    mapped->file = CreateFile2(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+    if ( mapped->file == INVALID_HANDLE_VALUE )
+        return nullptr;
+
+    // Empty files cannot be mapped.
+    LARGE_INTEGER size;
+    if ( !GetFileSizeEx(mapped->file, &size) || size.QuadPart == 0 )
+        return nullptr;
+
+    mapped->size = static_cast<uint64_t>(size.QuadPart);
+
+    mapped->mapping = CreateFileMappingFromApp(mapped->file, nullptr, PAGE_READONLY, 0, nullptr);
+    if ( mapped->mapping == nullptr )
+        return nullptr;
+
+    mapped->view = MapViewOfFileFromApp(mapped->mapping, FILE_MAP_READ, 0, 0);
+    if ( mapped->view == nullptr )
+        return nullptr;
+
+    return mapped;
+}
+
+MappedFile::~MappedFile()
+{
+    if ( view != nullptr )
+        UnmapViewOfFile(view);
+
+    if ( mapping != nullptr )
+        CloseHandle(mapping);
+
+    if ( file != INVALID_HANDLE_VALUE )
+        CloseHandle(file);
+}
+
+static inline uint64_t MixWord(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+uint64_t DisplayComplexity::HashBytes(const void* data, size_t size, uint64_t seed)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t hash = seed;
+
+    for ( size_t i = 0; i < size; i += 8 )
+    {
+        uint64_t word = 0;
+        memcpy(&word, bytes + i, size - i < 8 ? size - i : 8);
+
+        hash = (_rotl64(hash, 29) ^ MixWord(word)) * 0x9e3779b97f4a7c15ull;
+    }
+
+    return hash;
+}
+
+bool DisplayComplexity::HashMeshSource(const std::string& path, uint64_t optionsHash, MeshBlobKey& key)
+{
+    FILE* fp = nullptr;
+    fopen_s(&fp, path.c_str(), "rb");
+    if ( fp == nullptr )
+        return false;
+
+    std::vector<uint8_t> block(HashBlockSize);
+    uint64_t hash = 0, size = 0;
+
+    for ( size_t read; (read = fread(block.data(), 1, block.size(), fp)) > 0; )
+    {
+        hash = HashBytes(block.data(), read, hash);
+        size += read;
+    }
+
+    const bool failed = ferror(fp) != 0;
+    fclose(fp);
+
+    if ( failed )
+        return false;
+
+    key.sourceHash = MixWord(hash ^ size);
+    key.sourceSize = size;
+    key.optionsHash = optionsHash;
+
+    return true;
+}
+
+std::wstring DisplayComplexity::MeshBlobFilename(const std::wstring& directory, const std::string& path, uint64_t optionsHash)
+{
+    wchar_t name[32];
+    swprintf_s(name, L"%016llx.meshblob", static_cast<unsigned long long>(HashBytes(path.data(), path.size(), optionsHash)));
+
+    return directory + L"\\" + name;
+}
+
+std::shared_ptr<Mesh> DisplayComplexity::LoadMeshBlob(const std::wstring& filename, const MeshBlobKey& key)
+{
+    std::shared_ptr<MappedFile> file = MappedFile::Open(filename);
+    if ( file == nullptr || file->Size() < sizeof(MeshBlobHeader) )
+        return nullptr;
+
+    MeshBlobHeader header;
+    memcpy(&header, file->Data(), sizeof(header));
+
+    if ( memcmp(header.magic, MeshBlobMagic, sizeof(MeshBlobMagic)) != 0 ||
+        header.version != MeshBlobVersion ||
+        header.vertexSize != sizeof(VertexPositionColor) ||
+        header.key.sourceHash != key.sourceHash ||
+        header.key.sourceSize != key.sourceSize ||
+        header.key.optionsHash != key.optionsHash )
+        return nullptr;
+
+    // Counts are checked against the size before they are multiplied, so a
+    // damaged header cannot overflow into a size that matches.
+    const uint64_t payload = file->Size() - sizeof(MeshBlobHeader);
+
+    if ( header.vertexCount > payload / sizeof(VertexPositionColor) ||
+        header.indexCount > payload / sizeof(unsigned int) ||
+        header.vertexCount * sizeof(VertexPositionColor) + header.indexCount * sizeof(unsigned int) != payload )
+        return nullptr;
+
+    const uint8_t* vertices = file->Data() + sizeof(MeshBlobHeader);
+
+    std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
+    mesh->vertices = reinterpret_cast<const VertexPositionColor*>(vertices);
+    mesh->vertexCount = static_cast<size_t>(header.vertexCount);
+    mesh->indices = reinterpret_cast<const unsigned int*>(vertices + header.vertexCount * sizeof(VertexPositionColor));
+    mesh->indexCount = static_cast<size_t>(header.indexCount);
+    mesh->mappedFile = file;
+
+    return mesh;
+}
+
+bool DisplayComplexity::StoreMeshBlob(const std::wstring& filename, const MeshBlobKey& key, const Mesh& mesh)
+{
+    MeshBlobHeader header = {};
+    memcpy(header.magic, MeshBlobMagic, sizeof(MeshBlobMagic));
+    header.version = MeshBlobVersion;
+    header.vertexSize = sizeof(VertexPositionColor);
+    header.key = key;
+    header.vertexCount = mesh.vertexCount;
+    header.indexCount = mesh.indexCount;
+
+    const std::wstring temporary = filename + L".tmp";
+
+    FILE* fp = nullptr;
+    _wfopen_s(&fp, temporary.c_str(), L"wb");
+    if ( fp == nullptr )
+        return false;
+
+    bool written = fwrite(&header, sizeof(header), 1, fp) == 1;
+    written = written && fwrite(mesh.vertices, sizeof(VertexPositionColor), mesh.vertexCount, fp) == mesh.vertexCount;
+    written = written && fwrite(mesh.indices, sizeof(unsigned int), mesh.indexCount, fp) == mesh.indexCount;
+    written = fclose(fp) == 0 && written;
+
+    if ( !written || !MoveFileExW(temporary.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING) )
+    {
+        DeleteFileW(temporary.c_str());
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace DisplayComplexity
+{
+    class Mesh;
+
+    // A read-only view of a whole file, unmapped when the last owner lets go.
+    class MappedFile
+    {
+    public:
+        // nullptr if the file cannot be opened or mapped.
+        static std::shared_ptr<MappedFile> Open(const std::wstring& filename);
+
+        ~MappedFile();
+
+        const uint8_t* Data() const { return static_cast<const uint8_t*>(view); }
+        uint64_t Size() const { return size; }
+
+    private:
+        MappedFile() = default;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+        const void* view = nullptr;
+        uint64_t size = 0;
+    };
+
+    // What a cached mesh was built from. A blob is only used if all three
+    // match, so an edited source or changed settings rebuild the mesh.
+    struct MeshBlobKey
+    {
+        uint64_t sourceHash;  // of the source file's bytes
+        uint64_t sourceSize;
+        uint64_t optionsHash; // of the settings the mesh was built with
+    };
+
+    // Reads the source file once through a 64-bit hash; false if it cannot be read.
+    bool HashMeshSource(const std::string& path, uint64_t optionsHash, MeshBlobKey& key);
+
+    // One blob per source path and options, so a rebuilt mesh replaces the
+    // stale one instead of piling up next to it.
+    std::wstring MeshBlobFilename(const std::wstring& directory, const std::string& path, uint64_t optionsHash);
+
+    // Maps the blob and returns a mesh whose vertices and indices point into
+    // the mapping, without copying. nullptr if there is no blob, it was built
+    // from another key, or it is not a blob of this version.
+    std::shared_ptr<Mesh> LoadMeshBlob(const std::wstring& filename, const MeshBlobKey& key);
+
+    // Writes a temporary file and renames it over the blob, so a reader never
+    // maps half of one. False if the directory cannot be written.
+    bool StoreMeshBlob(const std::wstring& filename, const MeshBlobKey& key, const Mesh& mesh);
+
+    uint64_t HashBytes(const void* data, size_t size, uint64_t seed);
+}
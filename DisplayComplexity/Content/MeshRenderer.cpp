@@ -134,6 +134,10 @@ void MeshRenderer::CreateDeviceDependentResources()
     // incurred by setting the geometry shader stage.
     std::wstring vertexShaderFileName = m_usingVprtShaders ? L"ms-appx:///VprtVertexShader.cso" : L"ms-appx:///VertexShader.cso";
 
+    // Start the mesh first, so it is parsed on the thread pool while the shaders load.
+    // Every renderer asks for the same file, which the cache loads only once.
+    task<MeshHandle> loadMeshTask = MeshCache::GetInstance().GetMeshAsync(".\\Assets\\bunny.obj", ".\\Assets\\");
+
     // Load shaders asynchronously.
     task<std::vector<byte>> loadVSTask = DX::ReadDataAsync(vertexShaderFileName);
     task<std::vector<byte>> loadPSTask = DX::ReadDataAsync(L"ms-appx:///PixelShader.cso");
@@ -213,17 +217,19 @@ void MeshRenderer::CreateDeviceDependentResources()
         });
     }
 
-    // Once all shaders are loaded, create the mesh.
+    // Once all shaders and the mesh are loaded, create the mesh buffers. The
+    // handle is dropped once the buffers hold a copy, so the cache may evict it.
     task<void> shaderTaskGroup = m_usingVprtShaders ? (createPSTask && createVSTask) : (createPSTask && createVSTask && createGSTask);
-    task<void> createCubeTask = shaderTaskGroup.then([this] ()
+    task<void> createCubeTask = shaderTaskGroup.then([loadMeshTask] ()
+    {
+        return loadMeshTask;
+    }).then([this] (MeshHandle mesh)
     {
-        auto mesh = MeshCache::GetInstance().GetMesh(".\\Assets\\bunny.obj", ".\\Assets\\");
-
         D3D11_SUBRESOURCE_DATA vertexBufferData = { 0 };
-        vertexBufferData.pSysMem = mesh->meshVertices.data();
+        vertexBufferData.pSysMem = mesh->vertices;
         vertexBufferData.SysMemPitch = 0;
         vertexBufferData.SysMemSlicePitch = 0;
-        const CD3D11_BUFFER_DESC vertexBufferDesc(sizeof(VertexPositionColor) * mesh->meshVertices.size(), D3D11_BIND_VERTEX_BUFFER);
+        const CD3D11_BUFFER_DESC vertexBufferDesc(sizeof(VertexPositionColor) * mesh->vertexCount, D3D11_BIND_VERTEX_BUFFER);
         DX::ThrowIfFailed(
             m_deviceResources->GetD3DDevice()->CreateBuffer(
                 &vertexBufferDesc,
@@ -232,13 +238,13 @@ void MeshRenderer::CreateDeviceDependentResources()
             )
         );
 
-        m_indexCount = mesh->meshIndices.size();
+        m_indexCount = mesh->indexCount;
 
         D3D11_SUBRESOURCE_DATA indexBufferData = { 0 };
-        indexBufferData.pSysMem = mesh->meshIndices.data();
+        indexBufferData.pSysMem = mesh->indices;
         indexBufferData.SysMemPitch = 0;
         indexBufferData.SysMemSlicePitch = 0;
-        CD3D11_BUFFER_DESC indexBufferDesc(sizeof(unsigned int) * mesh->meshIndices.size(), D3D11_BIND_INDEX_BUFFER);
+        CD3D11_BUFFER_DESC indexBufferDesc(sizeof(unsigned int) * mesh->indexCount, D3D11_BIND_INDEX_BUFFER);
         DX::ThrowIfFailed(
             m_deviceResources->GetD3DDevice()->CreateBuffer(
                 &indexBufferDesc,
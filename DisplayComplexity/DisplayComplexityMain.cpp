@@ -28,6 +28,9 @@ DisplayComplexityMain::DisplayComplexityMain(const std::shared_ptr<DX::DeviceRes
     m_deviceResources->RegisterDeviceNotify(this);
 	
 	new MeshCache();
+
+	// Built meshes are kept as binary blobs, so later launches skip parsing.
+	MeshCache::GetInstance().SetDiskCacheDirectory(Windows::Storage::ApplicationData::Current->LocalCacheFolder->Path->Data());
 }
 
 void DisplayComplexityMain::SetHolographicSpace(HolographicSpace^ holographicSpace)
@@ -0,0 +1,488 @@
+#include "BinaryTree.h"
+
+#include <algorithm>
+#include <cassert>
+#include <ppl.h>
+
+using namespace DirectX;
+
+// tree->points mirrors tree->vertices, so the box and split scans run over
+// contiguous coordinates with the PointCloudSoA kernels, and every
+// partition moves a point in both.
+
+static inline void SwapPoints(BinaryTree* tree, size_t i, size_t j)
+{
+	std::swap(tree->vertices[i], tree->vertices[j]);
+	std::swap(tree->points.x[i], tree->points.x[j]);
+	std::swap(tree->points.y[i], tree->points.y[j]);
+	std::swap(tree->points.z[i], tree->points.z[j]);
+}
+
+// Moves the points of [begin, end) whose coordinate on axis satisfies
+// goesLeft before the others and returns where the others start.
+template <typename Predicate>
+static size_t PartitionPoints(BinaryTree* tree, size_t begin, size_t end, int axis, Predicate goesLeft)
+{
+	const float* coordinates = tree->points.Axis(axis);
+
+	for (;;) {
+		while (begin < end && goesLeft(coordinates[begin])) {
+			++begin;
+		}
+		while (begin < end && !goesLeft(coordinates[end - 1])) {
+			--end;
+		}
+		if (begin == end)
+			return begin;
+
+		SwapPoints(tree, begin++, --end);
+	}
+}
+
+// Union of box and the box of points [begin, end).
+static BoundingBox3D AddPointRange(BoundingBox3D box, const PointCloudSoA& points, size_t begin, size_t end)
+{
+	const BoundingBox3D range = ComputeBoundingBox(points, begin, end);
+
+	if (begin < end) {
+		box.AddPoint(range.Min);
+		box.AddPoint(range.Max);
+	}
+
+	return box;
+}
+
+static inline size_t VertexCount(const BinaryTreeNode* node)
+{
+	return node->end - node->begin;
+}
+
+// Splits parent at the midpoint of its widest axis that leaves both sides
+// non-empty, partitioning its range of tree->vertices in place. Returns false
+// if no axis does, i.e. all its vertices coincide.
+static bool SplitBinaryNode(BinaryTreeNode* parent, BoundingBox3D boundingBox, BoundingBox3D& leftBB, BoundingBox3D& rightBB)
+{
+	BinaryTree* tree = parent->tree;
+
+	boundingBox = AddPointRange(boundingBox, tree->points, parent->begin, parent->end);
+
+	float widths[3] = {
+		boundingBox.Max.x - boundingBox.Min.x,
+		boundingBox.Max.y - boundingBox.Min.y,
+		boundingBox.Max.z - boundingBox.Min.z
+	};
+
+	float mid[] = {
+		boundingBox.Min.x + widths[0] * 0.5f,
+		boundingBox.Min.y + widths[1] * 0.5f,
+		boundingBox.Min.z + widths[2] * 0.5f
+	};
+
+	int orderedIndices[3] = { 0 };
+	float minValue = FLT_MAX, maxValue = -FLT_MAX;
+
+	for (int i = 0; i < 3; ++i) {
+		if (widths[i] > maxValue) {
+			maxValue = widths[i];
+			orderedIndices[0] = i;
+		}
+		if (widths[i] < minValue) {
+			minValue = widths[i];
+			orderedIndices[2] = i;
+		}
+	}
+
+	for (int i = 0; i < 3; ++i) {
+		if (i != orderedIndices[0] && i != orderedIndices[2]) {
+			orderedIndices[1] = i;
+			break;
+		}
+	}
+
+	for (int currentIndex = 0; currentIndex < 3; ++currentIndex) {
+		const int maxIndices = orderedIndices[currentIndex];
+
+		// Left takes the vertices above mid; counted first, so an axis that
+		// leaves a side empty moves nothing.
+		const float split = mid[maxIndices];
+		const size_t aboveCount = CountAbove(tree->points, parent->begin, parent->end, maxIndices, split);
+
+		if (aboveCount == 0 || aboveCount == VertexCount(parent))
+			continue;
+
+		const size_t splitIndex = PartitionPoints(tree, parent->begin, parent->end, maxIndices, [split](float c) { return c > split; });
+		assert(splitIndex == parent->begin + aboveCount);
+
+		parent->left = tree->nodes.New();
+		parent->left->tree = tree;
+		parent->left->begin = parent->begin;
+		parent->left->end = splitIndex;
+
+		parent->right = tree->nodes.New();
+		parent->right->tree = tree;
+		parent->right->begin = splitIndex;
+		parent->right->end = parent->end;
+
+		leftBB = AddPointRange(leftBB, tree->points, parent->left->begin, parent->left->end);
+		rightBB = AddPointRange(rightBB, tree->points, parent->right->begin, parent->right->end);
+
+		return true;
+	}
+
+	return false;
+}
+
+static BoundingBox3D NodeBoundingBox(const BinaryTreeNode* node)
+{
+	return ComputeBoundingBox(node->tree->points, node->begin, node->end);
+}
+
+static void BuildBinarySubtree(BinaryTreeNode* parent, BoundingBox3D boundingBox, int depth, std::vector<BoundingBox3D>& boundingBoxes)
+{
+	BoundingBox3D leftBB, rightBB;
+	if (!SplitBinaryNode(parent, boundingBox, leftBB, rightBB)) {
+		boundingBoxes.push_back(NodeBoundingBox(parent));
+		return;
+	}
+
+	const size_t granularity = parent->tree->granularity;
+
+	if (VertexCount(parent->left) > granularity && depth - 1 > 0) {
+		BuildBinarySubtree(parent->left, leftBB, depth - 1, boundingBoxes);
+	}
+	else {
+		boundingBoxes.push_back(leftBB);
+	}
+
+	if (VertexCount(parent->right) > granularity && depth - 1 > 0) {
+		BuildBinarySubtree(parent->right, rightBB, depth - 1, boundingBoxes);
+	}
+	else {
+		boundingBoxes.push_back(rightBB);
+	}
+}
+
+// Both sides of a node with at least cutoff vertices are built as tasks into
+// their own box lists, which are appended left then right so the result has the
+// same order as the serial build.
+static void BuildBinarySubtreeParallel(BinaryTreeNode* parent, BoundingBox3D boundingBox, int depth, std::vector<BoundingBox3D>& boundingBoxes, size_t cutoff)
+{
+	if (VertexCount(parent) < cutoff) {
+		BuildBinarySubtree(parent, boundingBox, depth, boundingBoxes);
+		return;
+	}
+
+	BoundingBox3D leftBB, rightBB;
+	if (!SplitBinaryNode(parent, boundingBox, leftBB, rightBB)) {
+		boundingBoxes.push_back(NodeBoundingBox(parent));
+		return;
+	}
+
+	const size_t granularity = parent->tree->granularity;
+
+	std::vector<BoundingBox3D> leftBoxes, rightBoxes;
+	concurrency::task_group tasks;
+
+	if (VertexCount(parent->left) > granularity && depth - 1 > 0) {
+		tasks.run([&] { BuildBinarySubtreeParallel(parent->left, leftBB, depth - 1, leftBoxes, cutoff); });
+	}
+	else {
+		leftBoxes.push_back(leftBB);
+	}
+
+	if (VertexCount(parent->right) > granularity && depth - 1 > 0) {
+		tasks.run([&] { BuildBinarySubtreeParallel(parent->right, rightBB, depth - 1, rightBoxes, cutoff); });
+	}
+	else {
+		rightBoxes.push_back(rightBB);
+	}
+
+	tasks.wait();
+
+	boundingBoxes.insert(boundingBoxes.end(), leftBoxes.begin(), leftBoxes.end());
+	boundingBoxes.insert(boundingBoxes.end(), rightBoxes.begin(), rightBoxes.end());
+}
+
+// Median and BinnedSAH builds. A node is the range [begin, end) of
+// tree->vertices; its box is the one scan it costs besides the partition.
+
+static const int SAHBinCount = 16;
+
+static inline float coordinate(const XMFLOAT3* v, int axis)
+{
+	return (&v->x)[axis];
+}
+
+static inline float halfSurfaceArea(const BoundingBox3D& box)
+{
+	const float dx = box.Max.x - box.Min.x, dy = box.Max.y - box.Min.y, dz = box.Max.z - box.Min.z;
+	return dx * dy + dy * dz + dz * dx;
+}
+
+// nth_element moves the pointers, and the range's points are copied back
+// from them after.
+static size_t splitMedian(BinaryTree* tree, size_t begin, size_t end, const BoundingBox3D& box)
+{
+	XMFLOAT3** vertices = tree->vertices.data();
+	const float widths[3] = { box.Max.x - box.Min.x, box.Max.y - box.Min.y, box.Max.z - box.Min.z };
+	const int axis = widths[0] >= widths[1] && widths[0] >= widths[2] ? 0 : widths[1] >= widths[2] ? 1 : 2;
+	const size_t mid = begin + (end - begin) / 2;
+
+	std::nth_element(vertices + begin, vertices + mid, vertices + end,
+		[axis](const XMFLOAT3* a, const XMFLOAT3* b) { return coordinate(a, axis) < coordinate(b, axis); });
+
+	for (size_t i = begin; i < end; ++i) {
+		tree->points.x[i] = vertices[i]->x;
+		tree->points.y[i] = vertices[i]->y;
+		tree->points.z[i] = vertices[i]->z;
+	}
+
+	return mid;
+}
+
+static inline int sahBin(float c, float min, float scale)
+{
+	const int bin = static_cast<int>((c - min) * scale);
+	return std::min(std::max(bin, 0), SAHBinCount - 1);
+}
+
+// Splits between the bins with the lowest area * count cost on either side.
+// Falls back to the median when every axis puts all vertices in one bin.
+static size_t splitBinnedSAH(BinaryTree* tree, size_t begin, size_t end, const BoundingBox3D& box)
+{
+	const PointCloudSoA& points = tree->points;
+	const float* boxMin = &box.Min.x;
+	const float* boxMax = &box.Max.x;
+
+	float bestCost = FLT_MAX;
+	int bestAxis = -1, bestBin = 0;
+
+	for (int axis = 0; axis < 3; ++axis) {
+		const float extent = boxMax[axis] - boxMin[axis];
+		if (!(extent > 0))
+			continue;
+
+		const float scale = SAHBinCount / extent;
+		size_t counts[SAHBinCount] = { 0 };
+		BoundingBox3D bins[SAHBinCount];
+
+		const float* coordinates = points.Axis(axis);
+
+		for (size_t i = begin; i < end; ++i) {
+			const int bin = sahBin(coordinates[i], boxMin[axis], scale);
+			++counts[bin];
+			bins[bin].AddPoint(XMFLOAT3(points.x[i], points.y[i], points.z[i]));
+		}
+
+		// Sweep from the right, then from the left, splitting before bin b.
+		float rightArea[SAHBinCount];
+		size_t rightCount[SAHBinCount];
+		BoundingBox3D side;
+		size_t count = 0;
+
+		for (int b = SAHBinCount - 1; b > 0; --b) {
+			if (counts[b]) {
+				side.AddPoint(bins[b].Min);
+				side.AddPoint(bins[b].Max);
+				count += counts[b];
+			}
+			rightArea[b] = count ? halfSurfaceArea(side) : 0.f;
+			rightCount[b] = count;
+		}
+
+		side = BoundingBox3D();
+		count = 0;
+
+		for (int b = 1; b < SAHBinCount; ++b) {
+			if (counts[b - 1]) {
+				side.AddPoint(bins[b - 1].Min);
+				side.AddPoint(bins[b - 1].Max);
+				count += counts[b - 1];
+			}
+			if (count == 0 || rightCount[b] == 0)
+				continue;
+
+			const float cost = halfSurfaceArea(side) * count + rightArea[b] * rightCount[b];
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = b;
+			}
+		}
+	}
+
+	if (bestAxis < 0)
+		return splitMedian(tree, begin, end, box);
+
+	const float min = boxMin[bestAxis];
+	const float scale = SAHBinCount / (boxMax[bestAxis] - min);
+
+	return PartitionPoints(tree, begin, end, bestAxis, [=](float c) { return sahBin(c, min, scale) < bestBin; });
+}
+
+// Returns false, after adding the node's box, if the node is a leaf.
+static bool SplitPartitionedNode(BinaryTreeNode* node, int depth, BinaryTreeSplit split, std::vector<BoundingBox3D>& boundingBoxes)
+{
+	BinaryTree* tree = node->tree;
+	const size_t count = node->end - node->begin;
+	const BoundingBox3D boundingBox = ComputeBoundingBox(tree->points, node->begin, node->end);
+
+	if (depth <= 0 || count <= static_cast<size_t>(tree->granularity) || count < 2) {
+		boundingBoxes.push_back(boundingBox);
+		return false;
+	}
+
+	const size_t mid = split == BinaryTreeSplit::Median
+		? splitMedian(tree, node->begin, node->end, boundingBox)
+		: splitBinnedSAH(tree, node->begin, node->end, boundingBox);
+
+	assert(mid > node->begin && mid < node->end);
+
+	node->left = tree->nodes.New();
+	node->left->tree = tree;
+	node->left->begin = node->begin;
+	node->left->end = mid;
+
+	node->right = tree->nodes.New();
+	node->right->tree = tree;
+	node->right->begin = mid;
+	node->right->end = node->end;
+
+	return true;
+}
+
+static void BuildPartitionedSubtree(BinaryTreeNode* node, int depth, BinaryTreeSplit split, std::vector<BoundingBox3D>& boundingBoxes)
+{
+	if (SplitPartitionedNode(node, depth, split, boundingBoxes)) {
+		BuildPartitionedSubtree(node->left, depth - 1, split, boundingBoxes);
+		BuildPartitionedSubtree(node->right, depth - 1, split, boundingBoxes);
+	}
+}
+
+static void BuildPartitionedSubtreeParallel(BinaryTreeNode* node, int depth, BinaryTreeSplit split, std::vector<BoundingBox3D>& boundingBoxes, size_t cutoff)
+{
+	if (node->end - node->begin < cutoff) {
+		BuildPartitionedSubtree(node, depth, split, boundingBoxes);
+		return;
+	}
+
+	if (!SplitPartitionedNode(node, depth, split, boundingBoxes))
+		return;
+
+	// The two sides are disjoint ranges of tree->vertices.
+	std::vector<BoundingBox3D> leftBoxes, rightBoxes;
+	concurrency::task_group tasks;
+
+	tasks.run([&] { BuildPartitionedSubtreeParallel(node->left, depth - 1, split, leftBoxes, cutoff); });
+	BuildPartitionedSubtreeParallel(node->right, depth - 1, split, rightBoxes, cutoff);
+
+	tasks.wait();
+
+	boundingBoxes.insert(boundingBoxes.end(), leftBoxes.begin(), leftBoxes.end());
+	boundingBoxes.insert(boundingBoxes.end(), rightBoxes.begin(), rightBoxes.end());
+}
+
+void BinaryTree::Reset()
+{
+	rootNode = nullptr;
+	boundingBoxes.clear();
+	vertices.clear();
+	points.x.clear();
+	points.y.clear();
+	points.z.clear();
+	nodes.Reset();
+}
+
+// Builds over tree->vertices into an empty tree.
+static void BuildBinaryTreeNodes(BinaryTree* tree, int depth, int granularity, BinaryTreeSplit split, size_t cutoff)
+{
+	tree->granularity = granularity;
+
+	tree->rootNode = tree->nodes.New();
+	tree->rootNode->tree = tree;
+	tree->rootNode->end = tree->vertices.size();
+
+	if (tree->vertices.empty())
+		return;
+
+	tree->points.Assign(tree->vertices);
+
+	if (split != BinaryTreeSplit::Midpoint) {
+		if (cutoff > 0) {
+			BuildPartitionedSubtreeParallel(tree->rootNode, depth, split, tree->boundingBoxes, cutoff);
+		}
+		else {
+			BuildPartitionedSubtree(tree->rootNode, depth, split, tree->boundingBoxes);
+		}
+
+		return;
+	}
+
+	std::vector<XMFLOAT3*>& vertices = tree->vertices;
+	PointCloudSoA& points = tree->points;
+	BoundingBox3D boundingBox = ComputeBoundingBox(points, 0, points.size());
+
+	XMFLOAT3 median;
+	median.x = (boundingBox.Max.x + boundingBox.Min.x) * 0.5f;
+	median.y = (boundingBox.Max.y + boundingBox.Min.y) * 0.5f;
+	median.z = (boundingBox.Max.z + boundingBox.Min.z) * 0.5f;
+
+	for (int i = 0; i < vertices.size(); ++i) {
+		vertices[i]->x -= median.x;
+		vertices[i]->y -= median.y;
+		vertices[i]->z -= median.z;
+
+		points.x[i] -= median.x;
+		points.y[i] -= median.y;
+		points.z[i] -= median.z;
+	}
+
+	if (cutoff > 0) {
+		BuildBinarySubtreeParallel(tree->rootNode, boundingBox, depth, tree->boundingBoxes, cutoff);
+	}
+	else {
+		BuildBinarySubtree(tree->rootNode, boundingBox, depth, tree->boundingBoxes);
+	}
+
+	for (auto& bb : tree->boundingBoxes) {
+		bb.Max.x += median.x;
+		bb.Max.y += median.y;
+		bb.Max.z += median.z;
+
+		bb.Min.x += median.x;
+		bb.Min.y += median.y;
+		bb.Min.z += median.z;
+	}
+}
+
+BinaryTree* BuildBinaryTree(std::vector<XMFLOAT3*> vertices, int depth, int granularity, BinaryTreeSplit split)
+{
+	BinaryTree* tree = new BinaryTree();
+	tree->vertices = std::move(vertices);
+	BuildBinaryTreeNodes(tree, depth, granularity, split, 0);
+
+	return tree;
+}
+
+BinaryTree* BuildBinaryTreeParallel(std::vector<XMFLOAT3*> vertices, int depth, int granularity, BinaryTreeSplit split, size_t cutoff)
+{
+	BinaryTree* tree = new BinaryTree();
+	tree->vertices = std::move(vertices);
+	BuildBinaryTreeNodes(tree, depth, granularity, split, cutoff > 0 ? cutoff : 1);
+
+	return tree;
+}
+
+void RebuildBinaryTree(BinaryTree* tree, const std::vector<XMFLOAT3*>& vertices, int depth, int granularity, BinaryTreeSplit split)
+{
+	tree->Reset();
+	tree->vertices.assign(vertices.begin(), vertices.end());
+	BuildBinaryTreeNodes(tree, depth, granularity, split, 0);
+}
+
+void RebuildBinaryTreeParallel(BinaryTree* tree, const std::vector<XMFLOAT3*>& vertices, int depth, int granularity, BinaryTreeSplit split, size_t cutoff)
+{
+	tree->Reset();
+	tree->vertices.assign(vertices.begin(), vertices.end());
+	BuildBinaryTreeNodes(tree, depth, granularity, split, cutoff > 0 ? cutoff : 1);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+#include "BoundingBox3D.h"
+#include "NodeArena.h"
+#include "PointCloudSoA.h"
+
+struct BinaryTree;
+struct BinaryTreeNode;
+
+struct BinaryTreeNode {
+public:
+	size_t begin = 0, end = 0; // range of BinaryTree::vertices
+	BinaryTreeNode * left = nullptr, *right = nullptr;
+	BinaryTree* tree = nullptr;
+};
+
+struct BinaryTree {
+public:
+	BinaryTreeNode * rootNode = nullptr;
+	std::vector<BoundingBox3D> boundingBoxes;
+	int granularity = 1; // nodes with at most this many vertices are not split further
+	std::vector<DirectX::XMFLOAT3*> vertices; // partitioned in place by the build
+	PointCloudSoA points;                     // copy of vertices in the same order, which the split loops scan
+	NodeArena<BinaryTreeNode> nodes;          // owns every node, released with the tree
+
+	// Drops all nodes, boxes and vertices but keeps their memory for the next build.
+	void Reset();
+};
+
+enum class BinaryTreeSplit {
+	Midpoint,  // spatial midpoint of the widest axis, retrying the other axes when a side is empty.
+	           // The vertices themselves are recentered in place.
+	Median,    // nth_element median of the widest axis
+	BinnedSAH  // lowest surface area heuristic cost over 16 bins per axis
+};
+
+// Subtrees holding fewer vertices than this are built serially by BuildBinaryTreeParallel.
+const size_t DefaultBinaryTreeParallelCutoff = 8192;
+
+// Median and BinnedSAH never modify the vertices and always split a node into
+// two non-empty sides, so every level costs O(n) with no retries. Median is
+// balanced, i.e. O(n log n) overall.
+BinaryTree* BuildBinaryTree(std::vector<DirectX::XMFLOAT3*> vertices, int depth, int granularity, BinaryTreeSplit split = BinaryTreeSplit::Midpoint);
+
+// Same boundingBoxes, in the same order, as BuildBinaryTree, with independent
+// subtrees built as tasks on the PPL work-stealing scheduler.
+BinaryTree* BuildBinaryTreeParallel(std::vector<DirectX::XMFLOAT3*> vertices, int depth, int granularity, BinaryTreeSplit split = BinaryTreeSplit::Midpoint, size_t cutoff = DefaultBinaryTreeParallelCutoff);
+
+// Rebuild an existing tree in place, reusing its node and vertex memory.
+void RebuildBinaryTree(BinaryTree* tree, const std::vector<DirectX::XMFLOAT3*>& vertices, int depth, int granularity, BinaryTreeSplit split = BinaryTreeSplit::Midpoint);
+void RebuildBinaryTreeParallel(BinaryTree* tree, const std::vector<DirectX::XMFLOAT3*>& vertices, int depth, int granularity, BinaryTreeSplit split = BinaryTreeSplit::Midpoint, size_t cutoff = DefaultBinaryTreeParallelCutoff);
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cfloat>
+#include <DirectXMath.h>
+
+struct BoundingBox3D {
+	DirectX::XMFLOAT3 Min, Max;
+
+	BoundingBox3D()
+		: Min(FLT_MAX, FLT_MAX, FLT_MAX),
+		Max(-FLT_MAX, -FLT_MAX, -FLT_MAX) {}
+
+	BoundingBox3D(const DirectX::XMFLOAT3& Min, const DirectX::XMFLOAT3& Max)
+		: Min(Min), Max(Max) {}
+
+	void AddPoint(const DirectX::XMFLOAT3& p) {
+		Min.x = p.x < Min.x ? p.x : Min.x;
+		Min.y = p.y < Min.y ? p.y : Min.y;
+		Min.z = p.z < Min.z ? p.z : Min.z;
+
+		Max.x = p.x > Max.x ? p.x : Max.x;
+		Max.y = p.y > Max.y ? p.y : Max.y;
+		Max.z = p.z > Max.z ? p.z : Max.z;
+	}
+
+	bool IncludePoint(const DirectX::XMFLOAT3& p) const {
+		return Min.x < p.x && Min.y < p.y && Min.z < p.z
+			&& Max.x > p.x && Max.y > p.y && Max.z > p.z;
+	}
+};
@@ -0,0 +1,243 @@
+#include "IncrementalOctree.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace DirectX;
+
+bool IncrementalOctree::Contains(const XMFLOAT3& p) const
+{
+	return boundingBox.Min.x <= p.x && p.x <= boundingBox.Max.x
+		&& boundingBox.Min.y <= p.y && p.y <= boundingBox.Max.y
+		&& boundingBox.Min.z <= p.z && p.z <= boundingBox.Max.z;
+}
+
+static IncrementalOctreeNode* newNode(IncrementalOctree* octree, IncrementalOctreeNode* parent, uint64_t code, int level)
+{
+	IncrementalOctreeNode* node;
+
+	if (octree->freeNodes.empty()) {
+		node = octree->nodes.New();
+	}
+	else {
+		node = octree->freeNodes.back();
+		octree->freeNodes.pop_back();
+		*node = IncrementalOctreeNode();
+	}
+
+	node->code = code;
+	node->level = level;
+	node->parent = parent;
+
+	return node;
+}
+
+static void markDirty(IncrementalOctree* octree, uint32_t slot)
+{
+	if (octree->dirtyBegin == octree->dirtyEnd) {
+		octree->dirtyBegin = slot;
+		octree->dirtyEnd = slot + 1;
+	}
+	else {
+		octree->dirtyBegin = std::min(octree->dirtyBegin, slot);
+		octree->dirtyEnd = std::max(octree->dirtyEnd, slot + 1);
+	}
+}
+
+static void addBox(IncrementalOctree* octree, IncrementalOctreeNode* node)
+{
+	assert(node->boxIndex == IncrementalOctree::NoBox);
+
+	node->boxIndex = static_cast<uint32_t>(octree->boxGeometries.size());
+	octree->boxGeometries.push_back(GridCellBoundingBox(octree->boundingBox, node->code, node->level));
+	octree->boxNodes.push_back(node);
+
+	markDirty(octree, node->boxIndex);
+}
+
+// The last box moves into the freed slot, so the buffer stays dense.
+static void removeBox(IncrementalOctree* octree, IncrementalOctreeNode* node)
+{
+	const uint32_t slot = node->boxIndex;
+	const uint32_t last = static_cast<uint32_t>(octree->boxGeometries.size()) - 1;
+
+	assert(slot != IncrementalOctree::NoBox);
+
+	if (slot != last) {
+		octree->boxGeometries[slot] = octree->boxGeometries[last];
+		octree->boxNodes[slot] = octree->boxNodes[last];
+		octree->boxNodes[slot]->boxIndex = slot;
+		markDirty(octree, slot);
+	}
+
+	octree->boxGeometries.pop_back();
+	octree->boxNodes.pop_back();
+	node->boxIndex = IncrementalOctree::NoBox;
+}
+
+static int octantAt(uint64_t leafCode, int depth, int level)
+{
+	return static_cast<int>((leafCode >> (3 * (depth - level - 1))) & 7);
+}
+
+IncrementalOctree* createIncrementalOctree(const BoundingBox3D& box, int depth)
+{
+	assert(depth > 0 && depth <= LinearOctree::MaxDepth);
+
+	IncrementalOctree* octree = new IncrementalOctree();
+	octree->boundingBox = box;
+	octree->depth = depth;
+
+	return octree;
+}
+
+bool InsertPoint(IncrementalOctree* octree, const XMFLOAT3& p)
+{
+	if (!octree->Contains(p))
+		return false;
+
+	const int depth = octree->depth;
+	const uint64_t leafCode = GridPointCode(octree->boundingBox, depth, p);
+
+	if (!octree->rootNode) {
+		octree->rootNode = newNode(octree, nullptr, 0, 0);
+	}
+
+	IncrementalOctreeNode* node = octree->rootNode;
+	++node->pointCount;
+
+	for (int level = 0; level < depth; ++level) {
+		const int octant = octantAt(leafCode, depth, level);
+
+		if (!node->children[octant]) {
+			node->children[octant] = newNode(octree, node, (node->code << 3) | octant, level + 1);
+			node->childMask |= 1 << octant;
+		}
+
+		node = node->children[octant];
+		++node->pointCount;
+	}
+
+	if (node->pointCount > 1)
+		return true;
+
+	// A new leaf: no ancestor can be complete yet, since this cell was empty.
+	// Each ancestor that now has eight complete children takes over their boxes.
+	node->isCompleteSubtree = true;
+	addBox(octree, node);
+
+	for (IncrementalOctreeNode* parent = node->parent; parent && parent->childMask == 0xff; parent = parent->parent) {
+		for (auto child : parent->children) {
+			if (!child->isCompleteSubtree)
+				return true;
+		}
+
+		for (auto child : parent->children) {
+			removeBox(octree, child);
+		}
+
+		parent->isCompleteSubtree = true;
+		addBox(octree, parent);
+	}
+
+	return true;
+}
+
+bool RemovePoint(IncrementalOctree* octree, const XMFLOAT3& p)
+{
+	if (!octree->rootNode || !octree->Contains(p))
+		return false;
+
+	const int depth = octree->depth;
+	const uint64_t leafCode = GridPointCode(octree->boundingBox, depth, p);
+
+	// The topmost complete node on the path owns the box covering the cell.
+	IncrementalOctreeNode* node = octree->rootNode;
+	IncrementalOctreeNode* owner = node->isCompleteSubtree ? node : nullptr;
+
+	for (int level = 0; level < depth && node; ++level) {
+		node = node->children[octantAt(leafCode, depth, level)];
+		if (!owner && node && node->isCompleteSubtree)
+			owner = node;
+	}
+
+	if (!node)
+		return false;
+
+	IncrementalOctreeNode* leaf = node;
+
+	if (leaf->pointCount == 1) {
+		// Every node from the owner down loses completeness; its siblings off the
+		// path are still complete and become boxes of their own.
+		removeBox(octree, owner);
+
+		for (node = owner; node != leaf; ) {
+			const int pathOctant = octantAt(leafCode, depth, node->level);
+
+			node->isCompleteSubtree = false;
+			for (int octant = 0; octant < 8; ++octant) {
+				if (octant != pathOctant)
+					addBox(octree, node->children[octant]);
+			}
+
+			node = node->children[pathOctant];
+		}
+
+		leaf->isCompleteSubtree = false;
+	}
+
+	// Emptied nodes are unlinked bottom-up and recycled.
+	for (node = leaf; node; ) {
+		IncrementalOctreeNode* parent = node->parent;
+
+		if (--node->pointCount == 0) {
+			if (parent) {
+				const int octant = static_cast<int>(node->code & 7);
+				parent->children[octant] = nullptr;
+				parent->childMask &= ~(1 << octant);
+			}
+			else {
+				octree->rootNode = nullptr;
+			}
+			octree->freeNodes.push_back(node);
+		}
+
+		node = parent;
+	}
+
+	return true;
+}
+
+bool MovePoint(IncrementalOctree* octree, const XMFLOAT3& from, const XMFLOAT3& to)
+{
+	if (!octree->Contains(to))
+		return false;
+
+	const int depth = octree->depth;
+	const uint64_t toCode = GridPointCode(octree->boundingBox, depth, to);
+
+	if (octree->Contains(from) && GridPointCode(octree->boundingBox, depth, from) == toCode) {
+		const IncrementalOctreeNode* node = octree->rootNode;
+		for (int level = 0; level < depth && node; ++level) {
+			node = node->children[octantAt(toCode, depth, level)];
+		}
+		return node != nullptr;
+	}
+
+	if (!RemovePoint(octree, from))
+		return false;
+
+	return InsertPoint(octree, to);
+}
+
+size_t InsertPoints(IncrementalOctree* octree, const std::vector<XMFLOAT3*>& vertices)
+{
+	size_t inserted = 0;
+
+	for (auto v : vertices) {
+		if (InsertPoint(octree, *v))
+			++inserted;
+	}
+
+	return inserted;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "BoundingBox3D.h"
+#include "LinearOctree.h"
+#include "NodeArena.h"
+
+// Octree over a fixed box and depth that takes points one at a time, for
+// point streams that never see the whole set at once. Leaves are cells of the
+// LinearOctree grid and every node counts the points in its cell, so a point
+// is removed by decrementing the counts on its path.
+//
+// boxGeometries holds one box per topmost complete node, like
+// BuildLinearOctreeGeometry, but is patched in place: an update adds, removes
+// or swap-moves the boxes of the nodes on one path and their siblings, and
+// widens [dirtyBegin, dirtyEnd) over the slots it wrote.
+
+struct IncrementalOctreeNode {
+	uint64_t code = 0;            // Morton code of the cell at its own level
+	int level = 0;
+	uint32_t pointCount = 0;      // points inserted into the cell and not removed
+	uint32_t boxIndex = 0xffffffff; // slot in boxGeometries, if the node is a box
+	IncrementalOctreeNode* parent = nullptr;
+	IncrementalOctreeNode* children[8] = {}; // by octant, bit i of the octant is axis i
+	uint8_t childMask = 0;
+	bool isCompleteSubtree = false; // occupied leaf, or all eight children are complete
+};
+
+struct IncrementalOctree {
+	static const uint32_t NoBox = 0xffffffff;
+
+	BoundingBox3D boundingBox;
+	int depth = 0;
+
+	IncrementalOctreeNode* rootNode = nullptr;
+
+	std::vector<BoundingBox3D> boxGeometries;
+	std::vector<IncrementalOctreeNode*> boxNodes; // node of each box
+	uint32_t dirtyBegin = 0;
+	uint32_t dirtyEnd = 0; // may exceed boxGeometries.size() after removals
+
+	NodeArena<IncrementalOctreeNode> nodes;
+	std::vector<IncrementalOctreeNode*> freeNodes; // emptied nodes, reused before the arena grows
+
+	uint32_t PointCount() const { return rootNode ? rootNode->pointCount : 0; }
+	bool Contains(const DirectX::XMFLOAT3& p) const;
+	void ClearDirty() { dirtyBegin = dirtyEnd = 0; }
+};
+
+// depth is 1..LinearOctree::MaxDepth; points outside box are rejected.
+IncrementalOctree* createIncrementalOctree(const BoundingBox3D& box, int depth);
+
+// False if p is outside the box.
+bool InsertPoint(IncrementalOctree* octree, const DirectX::XMFLOAT3& p);
+
+// Removes one point from the cell of p. p need not be the inserted point
+// itself, only in the same cell; false if the cell is empty.
+bool RemovePoint(IncrementalOctree* octree, const DirectX::XMFLOAT3& p);
+
+// Removes from and inserts to; a move within one cell changes nothing. False,
+// and the octree is left unchanged, if either point is rejected.
+bool MovePoint(IncrementalOctree* octree, const DirectX::XMFLOAT3& from, const DirectX::XMFLOAT3& to);
+
+// Number of points accepted.
+size_t InsertPoints(IncrementalOctree* octree, const std::vector<DirectX::XMFLOAT3*>& vertices);
@@ -0,0 +1,208 @@
+#include "KdTree.h"
+
+#include <algorithm>
+#include <cassert>
+#include <ppl.h>
+
+using namespace DirectX;
+
+// Deep enough for any median build: a level halves the points.
+static const int MaxKdBuildDepth = 64;
+
+// Appends node and its subtree in preorder and returns its box.
+static BoundingBox3D AddKdNodes(KdTree* kd, const BinaryTreeNode* node)
+{
+	const uint32_t index = static_cast<uint32_t>(kd->nodes.size());
+	kd->nodes.push_back(KdTreeNode());
+
+	BoundingBox3D box;
+
+	if (!node->left) {
+		for (size_t i = node->begin; i < node->end; ++i) {
+			box.AddPoint(kd->points[i]);
+		}
+		kd->nodes[index].right = 0;
+	}
+	else {
+		const BoundingBox3D left = AddKdNodes(kd, node->left);
+		kd->nodes[index].right = static_cast<uint32_t>(kd->nodes.size());
+		const BoundingBox3D right = AddKdNodes(kd, node->right);
+
+		box.AddPoint(left.Min);
+		box.AddPoint(left.Max);
+		box.AddPoint(right.Min);
+		box.AddPoint(right.Max);
+	}
+
+	kd->nodes[index].boundingBox = box;
+	kd->nodes[index].begin = static_cast<uint32_t>(node->begin);
+	kd->nodes[index].end = static_cast<uint32_t>(node->end);
+
+	return box;
+}
+
+KdTree* createKdTree(const BinaryTree* tree)
+{
+	KdTree* kd = new KdTree();
+
+	if (!tree->rootNode || tree->vertices.empty())
+		return kd;
+
+	// Every node is a range of tree->vertices, so the points keep that order.
+	kd->sources = tree->vertices;
+	kd->points.reserve(tree->vertices.size());
+	for (const auto* v : tree->vertices) {
+		kd->points.push_back(*v);
+	}
+
+	AddKdNodes(kd, tree->rootNode);
+
+	return kd;
+}
+
+KdTree* createKdTree(const std::vector<XMFLOAT3*>& vertices, int leafSize)
+{
+	BinaryTree* tree = BuildBinaryTreeParallel(vertices, MaxKdBuildDepth, std::max(leafSize, 1), BinaryTreeSplit::Median);
+	KdTree* kd = createKdTree(tree);
+	delete tree;
+
+	return kd;
+}
+
+static inline float DistanceSquared(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+	const float dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+	return dx * dx + dy * dy + dz * dz;
+}
+
+static inline float BoxDistanceSquared(const BoundingBox3D& box, const XMFLOAT3& p)
+{
+	const float dx = std::max(std::max(box.Min.x - p.x, p.x - box.Max.x), 0.f);
+	const float dy = std::max(std::max(box.Min.y - p.y, p.y - box.Max.y), 0.f);
+	const float dz = std::max(std::max(box.Min.z - p.z, p.z - box.Max.z), 0.f);
+	return dx * dx + dy * dy + dz * dz;
+}
+
+static inline bool CloserNeighbor(const KdNeighbor& a, const KdNeighbor& b)
+{
+	return a.distanceSquared < b.distanceSquared;
+}
+
+// The k best so far are a max-heap in the caller's buffer; bound is the
+// heap's worst once it is full.
+struct NearestSearch {
+	const KdTree* tree;
+	XMFLOAT3 p;
+	size_t k;
+	KdNeighbor* heap;
+	size_t count;
+	float bound;
+
+	void Visit(uint32_t index) {
+		const KdTreeNode& node = tree->nodes[index];
+
+		if (!node.right) {
+			for (uint32_t i = node.begin; i < node.end; ++i) {
+				const float d = DistanceSquared(tree->points[i], p);
+				if (d > bound || (count == k && d == bound))
+					continue;
+
+				if (count == k) {
+					std::pop_heap(heap, heap + count, CloserNeighbor);
+					--count;
+				}
+				heap[count].distanceSquared = d;
+				heap[count].index = i;
+				std::push_heap(heap, heap + ++count, CloserNeighbor);
+
+				if (count == k) {
+					bound = heap[0].distanceSquared;
+				}
+			}
+			return;
+		}
+
+		const uint32_t children[2] = { index + 1, node.right };
+		const float distances[2] = {
+			BoxDistanceSquared(tree->nodes[children[0]].boundingBox, p),
+			BoxDistanceSquared(tree->nodes[children[1]].boundingBox, p)
+		};
+		const int nearer = distances[1] < distances[0] ? 1 : 0;
+
+		if (distances[nearer] <= bound) {
+			Visit(children[nearer]);
+		}
+		if (distances[1 - nearer] <= bound) {
+			Visit(children[1 - nearer]);
+		}
+	}
+};
+
+size_t FindNearestNeighbors(const KdTree* tree, const XMFLOAT3& p, size_t k, KdNeighbor* neighbors, float maxDistance)
+{
+	if (tree->nodes.empty() || k == 0)
+		return 0;
+
+	NearestSearch search = { tree, p, k, neighbors, 0, maxDistance < FLT_MAX ? maxDistance * maxDistance : FLT_MAX };
+
+	if (BoxDistanceSquared(tree->nodes[0].boundingBox, p) <= search.bound) {
+		search.Visit(0);
+	}
+
+	std::sort_heap(neighbors, neighbors + search.count, CloserNeighbor);
+
+	return search.count;
+}
+
+static void AddNeighborsInRadius(const KdTree* tree, uint32_t index, const XMFLOAT3& p, float radiusSquared, std::vector<KdNeighbor>& neighbors)
+{
+	const KdTreeNode& node = tree->nodes[index];
+
+	if (BoxDistanceSquared(node.boundingBox, p) > radiusSquared)
+		return;
+
+	if (!node.right) {
+		for (uint32_t i = node.begin; i < node.end; ++i) {
+			const float d = DistanceSquared(tree->points[i], p);
+			if (d <= radiusSquared) {
+				KdNeighbor neighbor = { d, i };
+				neighbors.push_back(neighbor);
+			}
+		}
+		return;
+	}
+
+	AddNeighborsInRadius(tree, index + 1, p, radiusSquared, neighbors);
+	AddNeighborsInRadius(tree, node.right, p, radiusSquared, neighbors);
+}
+
+size_t FindNeighborsInRadius(const KdTree* tree, const XMFLOAT3& p, float radius, std::vector<KdNeighbor>& neighbors)
+{
+	const size_t first = neighbors.size();
+
+	if (!tree->nodes.empty()) {
+		AddNeighborsInRadius(tree, 0, p, radius * radius, neighbors);
+	}
+
+	return neighbors.size() - first;
+}
+
+void FindNearestNeighborsBatch(const KdTree* tree, const std::vector<XMFLOAT3>& queries, size_t k, std::vector<KdNeighbor>& neighbors, float maxDistance)
+{
+	const KdNeighbor none = { FLT_MAX, NoKdNeighbor };
+	neighbors.assign(queries.size() * k, none);
+
+	concurrency::parallel_for(size_t(0), queries.size(), [&](size_t i) {
+		FindNearestNeighbors(tree, queries[i], k, neighbors.data() + k * i, maxDistance);
+	});
+}
+
+void FindNeighborsInRadiusBatch(const KdTree* tree, const std::vector<XMFLOAT3>& queries, float radius, std::vector<std::vector<KdNeighbor>>& neighbors)
+{
+	neighbors.resize(queries.size());
+
+	concurrency::parallel_for(size_t(0), queries.size(), [&](size_t i) {
+		neighbors[i].clear();
+		FindNeighborsInRadius(tree, queries[i], radius, neighbors[i]);
+	});
+}
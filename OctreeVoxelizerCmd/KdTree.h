@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "BoundingBox3D.h"
+#include "BinaryTree.h"
+
+// The split structure of a BinaryTree kept for queries: nodes in preorder with
+// the tight box of their points, and the points themselves copied in leaf
+// order, so a search touches two flat arrays and never the tree's vertex
+// pointers. Nearest neighbours and radius searches visit the nearer child
+// first and skip nodes whose box is farther than the current bound.
+
+struct KdTreeNode {
+	BoundingBox3D boundingBox;
+	uint32_t begin, end; // range of KdTree::points
+	uint32_t right;      // index of the right child, 0 for a leaf; the left child is the next node
+};
+
+struct KdTree {
+	std::vector<KdTreeNode> nodes;
+	std::vector<DirectX::XMFLOAT3> points;
+	std::vector<DirectX::XMFLOAT3*> sources; // vertex each point was copied from
+
+	size_t SizeInBytes() const { return nodes.size() * sizeof(KdTreeNode) + points.size() * (sizeof(DirectX::XMFLOAT3) + sizeof(DirectX::XMFLOAT3*)); }
+};
+
+struct KdNeighbor {
+	float distanceSquared;
+	uint32_t index; // into KdTree::points and KdTree::sources
+};
+
+const uint32_t NoKdNeighbor = 0xffffffff;
+
+// The points are copied as they are now: after a Midpoint build, recentered.
+KdTree* createKdTree(const BinaryTree* tree);
+
+// Median split down to leaves of at most leafSize points. The vertices are
+// not modified.
+KdTree* createKdTree(const std::vector<DirectX::XMFLOAT3*>& vertices, int leafSize = 8);
+
+// Writes the up to k nearest points within maxDistance of p to neighbors,
+// which must have room for k, nearest first. Returns how many were found.
+size_t FindNearestNeighbors(const KdTree* tree, const DirectX::XMFLOAT3& p, size_t k, KdNeighbor* neighbors, float maxDistance = FLT_MAX);
+
+// Appends every point within radius of p, in no particular order, and
+// returns how many.
+size_t FindNeighborsInRadius(const KdTree* tree, const DirectX::XMFLOAT3& p, float radius, std::vector<KdNeighbor>& neighbors);
+
+// One query per point, in parallel. Query i writes neighbors[k * i, k * i + k),
+// padded with { FLT_MAX, NoKdNeighbor } past the neighbours it found.
+void FindNearestNeighborsBatch(const KdTree* tree, const std::vector<DirectX::XMFLOAT3>& queries, size_t k, std::vector<KdNeighbor>& neighbors, float maxDistance = FLT_MAX);
+
+// One query per point, in parallel; neighbors[i] holds query i's points.
+void FindNeighborsInRadiusBatch(const KdTree* tree, const std::vector<DirectX::XMFLOAT3>& queries, float radius, std::vector<std::vector<KdNeighbor>>& neighbors);
@@ -0,0 +1,327 @@
+#include "LinearOctree.h"
+
+#include <algorithm>
+#include <cassert>
+#include <ppl.h>
+
+using namespace DirectX;
+
+int ChildCount(uint8_t childMask)
+{
+	int count = 0;
+	for (; childMask; childMask &= childMask - 1) {
+		++count;
+	}
+	return count;
+}
+
+BoundingBox3D GridCellBoundingBox(const BoundingBox3D& box, uint64_t code, int level)
+{
+	uint32_t x, y, z;
+	DecodeMorton3(code, &x, &y, &z);
+
+	const float cells = static_cast<float>(1u << level);
+	const XMFLOAT3 size(
+		(box.Max.x - box.Min.x) / cells,
+		(box.Max.y - box.Min.y) / cells,
+		(box.Max.z - box.Min.z) / cells);
+
+	return BoundingBox3D(
+		XMFLOAT3(box.Min.x + x * size.x, box.Min.y + y * size.y, box.Min.z + z * size.z),
+		XMFLOAT3(box.Min.x + (x + 1) * size.x, box.Min.y + (y + 1) * size.y, box.Min.z + (z + 1) * size.z));
+}
+
+uint64_t GridPointCode(const BoundingBox3D& box, int depth, const XMFLOAT3& p)
+{
+	const uint32_t last = (1u << depth) - 1;
+	const float cells = static_cast<float>(1u << depth);
+	const float* pMin = &box.Min.x;
+	const float* pMax = &box.Max.x;
+	const float* pPoint = &p.x;
+
+	uint32_t cell[3];
+	for (int axis = 0; axis < 3; ++axis) {
+		const float extent = pMax[axis] - pMin[axis];
+		const float t = extent > 0 ? (pPoint[axis] - pMin[axis]) * (cells / extent) : 0.f;
+		cell[axis] = t <= 0 ? 0 : std::min(static_cast<uint32_t>(t), last);
+	}
+
+	return EncodeMorton3(cell[0], cell[1], cell[2]);
+}
+
+BoundingBox3D LinearOctree::NodeBoundingBox(uint64_t code, int level) const
+{
+	return GridCellBoundingBox(boundingBox, code, level);
+}
+
+uint64_t LinearOctree::PointCode(const XMFLOAT3& p) const
+{
+	return GridPointCode(boundingBox, depth, p);
+}
+
+void BuildLinearOctreeLevels(LinearOctree* octree, std::vector<uint64_t>& leafCodes)
+{
+	assert(octree->depth > 0 && octree->depth <= LinearOctree::MaxDepth);
+	assert(std::is_sorted(leafCodes.begin(), leafCodes.end()));
+
+	const int depth = octree->depth;
+
+	// Every level is the deduplicated parent codes of the level below it.
+	std::vector<std::vector<uint64_t>> levels(depth + 1);
+	levels[depth].swap(leafCodes);
+
+	for (int level = depth; level > 0; --level) {
+		auto& parents = levels[level - 1];
+		parents.reserve(levels[level].size() / 2 + 1);
+
+		for (uint64_t code : levels[level]) {
+			if (parents.empty() || parents.back() != (code >> 3)) {
+				parents.push_back(code >> 3);
+			}
+		}
+	}
+
+	octree->levelOffsets.assign(depth + 2, 0);
+	for (int level = 0; level <= depth; ++level) {
+		octree->levelOffsets[level + 1] = octree->levelOffsets[level] + static_cast<uint32_t>(levels[level].size());
+	}
+
+	octree->nodes.resize(octree->levelOffsets[depth + 1]);
+	for (int level = 0; level <= depth; ++level) {
+		LinearOctreeNode* pNodes = octree->nodes.data() + octree->levelOffsets[level];
+
+		for (size_t i = 0; i < levels[level].size(); ++i) {
+			pNodes[i].code = levels[level][i];
+			pNodes[i].firstChild = 0;
+			pNodes[i].childMask = 0;
+			pNodes[i].isCompleteSubtree = level == depth;
+		}
+	}
+
+	// Children of a node are the run of next-level codes sharing its prefix.
+	for (int level = 0; level < depth; ++level) {
+		uint32_t child = octree->levelOffsets[level + 1];
+		const uint32_t childEnd = octree->levelOffsets[level + 2];
+
+		for (uint32_t i = octree->levelOffsets[level]; i < octree->levelOffsets[level + 1]; ++i) {
+			auto& node = octree->nodes[i];
+			node.firstChild = child;
+
+			while (child < childEnd && (octree->nodes[child].code >> 3) == node.code) {
+				node.childMask |= 1 << (octree->nodes[child].code & 7);
+				++child;
+			}
+		}
+	}
+
+	for (int level = depth - 1; level >= 0; --level) {
+		for (uint32_t i = octree->levelOffsets[level]; i < octree->levelOffsets[level + 1]; ++i) {
+			auto& node = octree->nodes[i];
+
+			if (node.childMask != 0xff) {
+				continue;
+			}
+
+			bool isFull = true;
+			for (uint32_t c = 0; c < 8; ++c) {
+				isFull = isFull && octree->nodes[node.firstChild + c].isCompleteSubtree;
+			}
+			node.isCompleteSubtree = isFull;
+		}
+	}
+}
+
+// Ranges shorter than PartitionSortCutoff are left to std::sort, which beats
+// another counting pass. Runs of at least PartitionTaskCutoff codes are
+// partitioned as tasks, and points are coded PointsPerTask at a time.
+static const size_t PartitionSortCutoff = 64;
+static const size_t PartitionTaskCutoff = 16384;
+static const size_t PointsPerTask = 4096;
+
+// Orders codes[0, count) by their octant digits from shift down to 0. Each
+// level counts the octant of every code once and permutes the range in place
+// into eight runs, an American flag sort, then does the same within each run.
+// Fills counts with the run sizes and returns whether the runs still need
+// partitioning: false if the range was sorted whole or shift was the last digit.
+static bool PartitionLevel(uint64_t* codes, size_t count, int shift, size_t counts[8])
+{
+	if (count < PartitionSortCutoff) {
+		std::sort(codes, codes + count);
+		return false;
+	}
+
+	std::fill(counts, counts + 8, size_t(0));
+	for (size_t i = 0; i < count; ++i) {
+		++counts[(codes[i] >> shift) & 7];
+	}
+
+	size_t next[8], end[8];
+	for (size_t octant = 0, offset = 0; octant < 8; ++octant) {
+		next[octant] = offset;
+		offset += counts[octant];
+		end[octant] = offset;
+	}
+
+	// Swaps every code into the run of its octant, so each move is final.
+	for (int octant = 0; octant < 8; ++octant) {
+		while (next[octant] < end[octant]) {
+			const uint64_t code = codes[next[octant]];
+			const int target = static_cast<int>((code >> shift) & 7);
+
+			if (target == octant) {
+				++next[octant];
+			}
+			else {
+				std::swap(codes[next[octant]], codes[next[target]++]);
+			}
+		}
+	}
+
+	return shift > 0;
+}
+
+static void PartitionCodes(uint64_t* codes, size_t count, int shift)
+{
+	size_t counts[8];
+	if (!PartitionLevel(codes, count, shift, counts))
+		return;
+
+	for (size_t octant = 0, offset = 0; octant < 8; offset += counts[octant++]) {
+		if (counts[octant] > 1) {
+			PartitionCodes(codes + offset, counts[octant], shift - 3);
+		}
+	}
+}
+
+// The runs of a partitioned range are disjoint, so the large ones are
+// partitioned as tasks on the work-stealing pool while this one does the rest.
+static void PartitionCodesParallel(uint64_t* codes, size_t count, int shift)
+{
+	if (count < PartitionTaskCutoff) {
+		PartitionCodes(codes, count, shift);
+		return;
+	}
+
+	size_t counts[8];
+	if (!PartitionLevel(codes, count, shift, counts))
+		return;
+
+	concurrency::task_group tasks;
+
+	for (size_t octant = 0, offset = 0; octant < 8; offset += counts[octant++]) {
+		uint64_t* run = codes + offset;
+		const size_t runCount = counts[octant];
+
+		if (runCount >= PartitionTaskCutoff) {
+			tasks.run([=] { PartitionCodesParallel(run, runCount, shift - 3); });
+		}
+		else if (runCount > 1) {
+			PartitionCodes(run, runCount, shift - 3);
+		}
+	}
+
+	tasks.wait();
+}
+
+void SortLeafCodes(std::vector<uint64_t>& codes, int depth)
+{
+	assert(depth > 0 && depth <= LinearOctree::MaxDepth);
+
+	PartitionCodesParallel(codes.data(), codes.size(), 3 * (depth - 1));
+	codes.erase(std::unique(codes.begin(), codes.end()), codes.end());
+}
+
+LinearOctree* createLinearOctree(const std::vector<XMFLOAT3*>& vertices, int depth)
+{
+	assert(depth > 0 && depth <= LinearOctree::MaxDepth);
+
+	LinearOctree* octree = new LinearOctree();
+	octree->depth = depth;
+
+	for (auto* vertex : vertices) {
+		octree->boundingBox.AddPoint(*vertex);
+	}
+
+	std::vector<uint64_t> codes(vertices.size());
+
+	concurrency::parallel_for(size_t(0), (codes.size() + PointsPerTask - 1) / PointsPerTask, [&](size_t task) {
+		const size_t end = std::min((task + 1) * PointsPerTask, codes.size());
+		for (size_t i = task * PointsPerTask; i < end; ++i) {
+			codes[i] = octree->PointCode(*vertices[i]);
+		}
+	});
+
+	SortLeafCodes(codes, depth);
+	BuildLinearOctreeLevels(octree, codes);
+
+	return octree;
+}
+
+LinearOctree* createCoarserLinearOctree(const LinearOctree* octree, int depth)
+{
+	assert(depth >= 0 && depth <= octree->depth);
+
+	LinearOctree* coarse = new LinearOctree();
+	coarse->boundingBox = octree->boundingBox;
+	coarse->depth = depth;
+
+	if (octree->nodes.empty()) {
+		coarse->levelOffsets.assign(depth + 2, 0);
+		return coarse;
+	}
+
+	coarse->levelOffsets.assign(octree->levelOffsets.begin(), octree->levelOffsets.begin() + depth + 2);
+	coarse->nodes.assign(octree->nodes.begin(), octree->nodes.begin() + coarse->levelOffsets[depth + 1]);
+
+	for (uint32_t i = coarse->levelOffsets[depth]; i < coarse->levelOffsets[depth + 1]; ++i) {
+		coarse->nodes[i].firstChild = 0;
+		coarse->nodes[i].childMask = 0;
+		coarse->nodes[i].isCompleteSubtree = true;
+	}
+
+	// New leaves can complete their ancestors; complete nodes stay complete.
+	for (int level = depth - 1; level >= 0; --level) {
+		for (uint32_t i = coarse->levelOffsets[level]; i < coarse->levelOffsets[level + 1]; ++i) {
+			auto& node = coarse->nodes[i];
+
+			if (node.isCompleteSubtree || node.childMask != 0xff) {
+				continue;
+			}
+
+			bool isFull = true;
+			for (uint32_t c = 0; c < 8; ++c) {
+				isFull = isFull && coarse->nodes[node.firstChild + c].isCompleteSubtree;
+			}
+			node.isCompleteSubtree = isFull;
+		}
+	}
+
+	return coarse;
+}
+
+void BuildLinearOctreeGeometry(const LinearOctree* octree, std::vector<BoundingBox3D>& boxGeometries)
+{
+	if (!octree || octree->nodes.empty())
+		return;
+
+	// Depth-first in octant order, emitting the topmost complete node of every branch.
+	std::vector<std::pair<uint32_t, int>> stack;
+	stack.push_back(std::make_pair(0u, 0));
+
+	while (!stack.empty()) {
+		const uint32_t index = stack.back().first;
+		const int level = stack.back().second;
+		stack.pop_back();
+
+		const auto& node = octree->nodes[index];
+
+		if (node.isCompleteSubtree) {
+			boxGeometries.push_back(octree->NodeBoundingBox(node.code, level));
+			continue;
+		}
+
+		for (int i = ChildCount(node.childMask) - 1; i >= 0; --i) {
+			stack.push_back(std::make_pair(node.firstChild + i, level + 1));
+		}
+	}
+}
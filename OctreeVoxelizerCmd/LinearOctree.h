@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "BoundingBox3D.h"
+#include "Morton.h"
+
+// Pointerless octree. The nodes of each level are stored contiguously and
+// sorted by Morton code, the children of a node are a contiguous run in the
+// next level, and node boxes are derived from (code, level) on demand.
+
+struct LinearOctreeNode {
+	uint64_t code;          // Morton code of the cell at its own level
+	uint32_t firstChild;    // index into LinearOctree::nodes, valid if childMask != 0
+	uint8_t childMask;      // bit i is set if octant i is occupied
+	bool isCompleteSubtree; // leaf, or all eight children are complete. A complete
+	                        // node may have its subtree pruned (childMask 0).
+};
+
+struct LinearOctree {
+	static const int MaxDepth = MortonBitsPerAxis;
+
+	BoundingBox3D boundingBox;
+	int depth = 0;
+
+	std::vector<LinearOctreeNode> nodes;
+	std::vector<uint32_t> levelOffsets; // level l is nodes[levelOffsets[l], levelOffsets[l + 1])
+
+	uint32_t LevelSize(int level) const { return levelOffsets[level + 1] - levelOffsets[level]; }
+	BoundingBox3D NodeBoundingBox(uint64_t code, int level) const;
+	uint64_t PointCode(const DirectX::XMFLOAT3& p) const; // leaf-level code, clamped to the box
+};
+
+int ChildCount(uint8_t childMask);
+
+// Cells of a grid of 2^depth cells per axis over box, shared with other trees
+// on the same grid. GridPointCode clamps p to the box.
+BoundingBox3D GridCellBoundingBox(const BoundingBox3D& box, uint64_t code, int level);
+uint64_t GridPointCode(const BoundingBox3D& box, int depth, const DirectX::XMFLOAT3& p);
+
+// Fills nodes and levelOffsets from sorted, unique leaf codes. boundingBox and
+// depth must already be set; leafCodes is consumed.
+void BuildLinearOctreeLevels(LinearOctree* octree, std::vector<uint64_t>& leafCodes);
+
+// Sorts and deduplicates the leaf codes of a grid of the given depth. Codes are
+// partitioned in place by octant one level at a time, like the subtrees of a
+// pointer octree, so the cost is O(n depth) with no per-node buffers. Large
+// runs are partitioned in parallel; the result is the same as std::sort's.
+void SortLeafCodes(std::vector<uint64_t>& codes, int depth);
+
+LinearOctree* createLinearOctree(const std::vector<DirectX::XMFLOAT3*>& vertices, int depth);
+
+// The same voxels at a coarser depth (<= octree->depth): levels below depth are
+// dropped, so a cell is occupied if any of its finer cells was.
+LinearOctree* createCoarserLinearOctree(const LinearOctree* octree, int depth);
+void BuildLinearOctreeGeometry(const LinearOctree* octree, std::vector<BoundingBox3D>& boxGeometries);
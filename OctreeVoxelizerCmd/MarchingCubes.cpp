@@ -0,0 +1,663 @@
+#include "MarchingCubes.h"
+
+#include <algorithm>
+#include <ppl.h>
+
+#include "Morton.h"
+#include "VoxelHashTable.h"
+
+using namespace DirectX;
+
+// Cubes per brick along each axis, and the side of the aligned cell blocks
+// whose occupancy is summarized to skip bricks.
+static const int SurfaceBrickSize = 32;
+
+// A triangle's edge key keeps, above this bit, which axes to step along to
+// the brick that owns the edge: one of the brick's seven upper neighbours.
+static const int OwnerStepShift = 61;
+static const uint64_t EdgeKeyMask = (1ull << OwnerStepShift) - 1;
+
+// Corner i of a cube is at offset (i & 1, i >> 1 & 1, i >> 2 & 1), like an
+// octant. Edge 4 * axis + k joins the k-th corner with that axis' bit clear to
+// the corner one step along the axis.
+static const uint8_t EdgeCorners[12] = { 0, 2, 4, 6, 0, 1, 4, 5, 0, 1, 2, 3 };
+
+// Triangles per cube case (bit i set: corner i inside) as edge triples, ended
+// by -1. Generated by chaining the face segments of each case into loops,
+// ambiguous faces separating the inside corners, and fanning every loop with
+// its normal pointing out.
+static const int8_t TriangleTable[256][16] = {
+	{ -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 9, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 9, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 10, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 10, 8, 1, 8, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 9, 5, 1, 10, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 10, 8, 1, 8, 9, 1, 9, 5, -1, -1, -1, -1, -1, -1, -1 },
+	{ 5, 11, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 0, 5, 11, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 9, 11, 0, 11, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 9, 4, 9, 11, 4, 11, 1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 5, 11, 10, 5, 10, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 5, 11, 10, 5, 10, 8, 5, 8, 0, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 9, 11, 0, 11, 10, 0, 10, 4, -1, -1, -1, -1, -1, -1, -1 },
+	{ 9, 11, 10, 9, 10, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 2, 8, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 6, 2, 4, 2, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 9, 5, 2, 8, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 2, 9, 5, 2, 5, 4, 2, 4, 6, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 10, 4, 2, 8, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 10, 6, 1, 6, 2, 1, 2, 0, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 9, 5, 1, 10, 4, 2, 8, 6, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 10, 6, 1, 6, 2, 1, 2, 9, 1, 9, 5, -1, -1, -1, -1 },
+	{ 5, 11, 1, 2, 8, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 6, 2, 4, 2, 0, 5, 11, 1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 9, 11, 0, 11, 1, 2, 8, 6, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 6, 2, 4, 2, 9, 4, 9, 11, 4, 11, 1, -1, -1, -1, -1 },
+	{ 2, 8, 6, 5, 11, 10, 5, 10, 4, -1, -1, -1, -1, -1, -1, -1 },
+	{ 5, 11, 10, 5, 10, 6, 5, 6, 2, 5, 2, 0, -1, -1, -1, -1 },
+	{ 0, 9, 11, 0, 11, 10, 0, 10, 4, 2, 8, 6, -1, -1, -1, -1 },
+	{ 2, 9, 11, 2, 11, 10, 2, 10, 6, -1, -1, -1, -1, -1, -1, -1 },
+	{ 7, 9, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 0, 7, 9, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 2, 7, 0, 7, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 7, 5, 4, 7, 4, 8, 7, 8, 2, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 10, 4, 7, 9, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 10, 8, 1, 8, 0, 7, 9, 2, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 2, 7, 0, 7, 5, 1, 10, 4, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 10, 8, 1, 8, 2, 1, 2, 7, 1, 7, 5, -1, -1, -1, -1 },
+	{ 5, 11, 1, 7, 9, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 0, 5, 11, 1, 7, 9, 2, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 2, 7, 0, 7, 11, 0, 11, 1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 2, 4, 2, 7, 4, 7, 11, 4, 11, 1, -1, -1, -1, -1 },
+	{ 7, 9, 2, 5, 11, 10, 5, 10, 4, -1, -1, -1, -1, -1, -1, -1 },
+	{ 5, 11, 10, 5, 10, 8, 5, 8, 0, 7, 9, 2, -1, -1, -1, -1 },
+	{ 0, 2, 7, 0, 7, 11, 0, 11, 10, 0, 10, 4, -1, -1, -1, -1 },
+	{ 7, 11, 10, 7, 10, 8, 7, 8, 2, -1, -1, -1, -1, -1, -1, -1 },
+	{ 7, 9, 8, 7, 8, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 6, 7, 4, 7, 9, 4, 9, 0, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 8, 6, 0, 6, 7, 0, 7, 5, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 6, 7, 4, 7, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 10, 4, 7, 9, 8, 7, 8, 6, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 10, 6, 1, 6, 7, 1, 7, 9, 1, 9, 0, -1, -1, -1, -1 },
+	{ 0, 8, 6, 0, 6, 7, 0, 7, 5, 1, 10, 4, -1, -1, -1, -1 },
+	{ 1, 10, 6, 1, 6, 7, 1, 7, 5, -1, -1, -1, -1, -1, -1, -1 },
+	{ 5, 11, 1, 7, 9, 8, 7, 8, 6, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 6, 7, 4, 7, 9, 4, 9, 0, 5, 11, 1, -1, -1, -1, -1 },
+	{ 0, 8, 6, 0, 6, 7, 0, 7, 11, 0, 11, 1, -1, -1, -1, -1 },
+	{ 4, 6, 7, 4, 7, 11, 4, 11, 1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 5, 11, 10, 5, 10, 4, 7, 9, 8, 7, 8, 6, -1, -1, -1, -1 },
+	{ 5, 11, 10, 5, 10, 6, 5, 6, 7, 5, 7, 9, 5, 9, 0, -1 },
+	{ 0, 8, 6, 0, 6, 7, 0, 7, 11, 0, 11, 10, 0, 10, 4, -1 },
+	{ 7, 11, 10, 7, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 6, 10, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 0, 6, 10, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 9, 5, 6, 10, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 6, 10, 3, 4, 8, 9, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 3, 6, 1, 6, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 3, 6, 1, 6, 8, 1, 8, 0, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 9, 5, 1, 3, 6, 1, 6, 4, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 3, 6, 1, 6, 8, 1, 8, 9, 1, 9, 5, -1, -1, -1, -1 },
+	{ 5, 11, 1, 6, 10, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 0, 5, 11, 1, 6, 10, 3, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 9, 11, 0, 11, 1, 6, 10, 3, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 9, 4, 9, 11, 4, 11, 1, 6, 10, 3, -1, -1, -1, -1 },
+	{ 6, 4, 5, 6, 5, 11, 6, 11, 3, -1, -1, -1, -1, -1, -1, -1 },
+	{ 5, 11, 3, 5, 3, 6, 5, 6, 8, 5, 8, 0, -1, -1, -1, -1 },
+	{ 0, 9, 11, 0, 11, 3, 0, 3, 6, 0, 6, 4, -1, -1, -1, -1 },
+	{ 6, 8, 9, 6, 9, 11, 6, 11, 3, -1, -1, -1, -1, -1, -1, -1 },
+	{ 2, 8, 10, 2, 10, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 10, 3, 4, 3, 2, 4, 2, 0, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 9, 5, 2, 8, 10, 2, 10, 3, -1, -1, -1, -1, -1, -1, -1 },
+	{ 2, 9, 5, 2, 5, 4, 2, 4, 10, 2, 10, 3, -1, -1, -1, -1 },
+	{ 1, 3, 2, 1, 2, 8, 1, 8, 4, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 3, 2, 1, 2, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 9, 5, 1, 3, 2, 1, 2, 8, 1, 8, 4, -1, -1, -1, -1 },
+	{ 1, 3, 2, 1, 2, 9, 1, 9, 5, -1, -1, -1, -1, -1, -1, -1 },
+	{ 5, 11, 1, 2, 8, 10, 2, 10, 3, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 10, 3, 4, 3, 2, 4, 2, 0, 5, 11, 1, -1, -1, -1, -1 },
+	{ 0, 9, 11, 0, 11, 1, 2, 8, 10, 2, 10, 3, -1, -1, -1, -1 },
+	{ 4, 10, 3, 4, 3, 2, 4, 2, 9, 4, 9, 11, 4, 11, 1, -1 },
+	{ 2, 8, 4, 2, 4, 5, 2, 5, 11, 2, 11, 3, -1, -1, -1, -1 },
+	{ 5, 11, 3, 5, 3, 2, 5, 2, 0, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 9, 11, 0, 11, 3, 0, 3, 2, 0, 2, 8, 0, 8, 4, -1 },
+	{ 2, 9, 11, 2, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 7, 9, 2, 6, 10, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 0, 7, 9, 2, 6, 10, 3, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 2, 7, 0, 7, 5, 6, 10, 3, -1, -1, -1, -1, -1, -1, -1 },
+	{ 7, 5, 4, 7, 4, 8, 7, 8, 2, 6, 10, 3, -1, -1, -1, -1 },
+	{ 1, 3, 6, 1, 6, 4, 7, 9, 2, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 3, 6, 1, 6, 8, 1, 8, 0, 7, 9, 2, -1, -1, -1, -1 },
+	{ 0, 2, 7, 0, 7, 5, 1, 3, 6, 1, 6, 4, -1, -1, -1, -1 },
+	{ 1, 3, 6, 1, 6, 8, 1, 8, 2, 1, 2, 7, 1, 7, 5, -1 },
+	{ 5, 11, 1, 7, 9, 2, 6, 10, 3, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 0, 5, 11, 1, 7, 9, 2, 6, 10, 3, -1, -1, -1, -1 },
+	{ 0, 2, 7, 0, 7, 11, 0, 11, 1, 6, 10, 3, -1, -1, -1, -1 },
+	{ 4, 8, 2, 4, 2, 7, 4, 7, 11, 4, 11, 1, 6, 10, 3, -1 },
+	{ 7, 9, 2, 6, 4, 5, 6, 5, 11, 6, 11, 3, -1, -1, -1, -1 },
+	{ 5, 11, 3, 5, 3, 6, 5, 6, 8, 5, 8, 0, 7, 9, 2, -1 },
+	{ 0, 2, 7, 0, 7, 11, 0, 11, 3, 0, 3, 6, 0, 6, 4, -1 },
+	{ 7, 11, 3, 7, 3, 6, 7, 6, 8, 7, 8, 2, -1, -1, -1, -1 },
+	{ 7, 9, 8, 7, 8, 10, 7, 10, 3, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 10, 3, 4, 3, 7, 4, 7, 9, 4, 9, 0, -1, -1, -1, -1 },
+	{ 0, 8, 10, 0, 10, 3, 0, 3, 7, 0, 7, 5, -1, -1, -1, -1 },
+	{ 7, 5, 4, 7, 4, 10, 7, 10, 3, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 3, 7, 1, 7, 9, 1, 9, 8, 1, 8, 4, -1, -1, -1, -1 },
+	{ 1, 3, 7, 1, 7, 9, 1, 9, 0, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 8, 4, 0, 4, 1, 0, 1, 3, 0, 3, 7, 0, 7, 5, -1 },
+	{ 1, 3, 7, 1, 7, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 5, 11, 1, 7, 9, 8, 7, 8, 10, 7, 10, 3, -1, -1, -1, -1 },
+	{ 4, 10, 3, 4, 3, 7, 4, 7, 9, 4, 9, 0, 5, 11, 1, -1 },
+	{ 0, 8, 10, 0, 10, 3, 0, 3, 7, 0, 7, 11, 0, 11, 1, -1 },
+	{ 4, 10, 3, 4, 3, 7, 4, 7, 11, 4, 11, 1, -1, -1, -1, -1 },
+	{ 7, 9, 8, 7, 8, 4, 7, 4, 5, 7, 5, 11, 7, 11, 3, -1 },
+	{ 5, 11, 3, 5, 3, 7, 5, 7, 9, 5, 9, 0, -1, -1, -1, -1 },
+	{ 0, 8, 4, 7, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 7, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 3, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 0, 3, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 9, 5, 3, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 3, 11, 7, 4, 8, 9, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 10, 4, 3, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 10, 8, 1, 8, 0, 3, 11, 7, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 9, 5, 1, 10, 4, 3, 11, 7, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 10, 8, 1, 8, 9, 1, 9, 5, 3, 11, 7, -1, -1, -1, -1 },
+	{ 5, 7, 3, 5, 3, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 0, 5, 7, 3, 5, 3, 1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 9, 7, 0, 7, 3, 0, 3, 1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 9, 4, 9, 7, 4, 7, 3, 4, 3, 1, -1, -1, -1, -1 },
+	{ 3, 10, 4, 3, 4, 5, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1 },
+	{ 5, 7, 3, 5, 3, 10, 5, 10, 8, 5, 8, 0, -1, -1, -1, -1 },
+	{ 0, 9, 7, 0, 7, 3, 0, 3, 10, 0, 10, 4, -1, -1, -1, -1 },
+	{ 3, 10, 8, 3, 8, 9, 3, 9, 7, -1, -1, -1, -1, -1, -1, -1 },
+	{ 2, 8, 6, 3, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 6, 2, 4, 2, 0, 3, 11, 7, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 9, 5, 2, 8, 6, 3, 11, 7, -1, -1, -1, -1, -1, -1, -1 },
+	{ 2, 9, 5, 2, 5, 4, 2, 4, 6, 3, 11, 7, -1, -1, -1, -1 },
+	{ 1, 10, 4, 2, 8, 6, 3, 11, 7, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 10, 6, 1, 6, 2, 1, 2, 0, 3, 11, 7, -1, -1, -1, -1 },
+	{ 0, 9, 5, 1, 10, 4, 2, 8, 6, 3, 11, 7, -1, -1, -1, -1 },
+	{ 1, 10, 6, 1, 6, 2, 1, 2, 9, 1, 9, 5, 3, 11, 7, -1 },
+	{ 5, 7, 3, 5, 3, 1, 2, 8, 6, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 6, 2, 4, 2, 0, 5, 7, 3, 5, 3, 1, -1, -1, -1, -1 },
+	{ 0, 9, 7, 0, 7, 3, 0, 3, 1, 2, 8, 6, -1, -1, -1, -1 },
+	{ 4, 6, 2, 4, 2, 9, 4, 9, 7, 4, 7, 3, 4, 3, 1, -1 },
+	{ 2, 8, 6, 3, 10, 4, 3, 4, 5, 3, 5, 7, -1, -1, -1, -1 },
+	{ 5, 7, 3, 5, 3, 10, 5, 10, 6, 5, 6, 2, 5, 2, 0, -1 },
+	{ 0, 9, 7, 0, 7, 3, 0, 3, 10, 0, 10, 4, 2, 8, 6, -1 },
+	{ 2, 9, 7, 2, 7, 3, 2, 3, 10, 2, 10, 6, -1, -1, -1, -1 },
+	{ 3, 11, 9, 3, 9, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 0, 3, 11, 9, 3, 9, 2, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 2, 3, 0, 3, 11, 0, 11, 5, -1, -1, -1, -1, -1, -1, -1 },
+	{ 3, 11, 5, 3, 5, 4, 3, 4, 8, 3, 8, 2, -1, -1, -1, -1 },
+	{ 1, 10, 4, 3, 11, 9, 3, 9, 2, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 10, 8, 1, 8, 0, 3, 11, 9, 3, 9, 2, -1, -1, -1, -1 },
+	{ 0, 2, 3, 0, 3, 11, 0, 11, 5, 1, 10, 4, -1, -1, -1, -1 },
+	{ 1, 10, 8, 1, 8, 2, 1, 2, 3, 1, 3, 11, 1, 11, 5, -1 },
+	{ 5, 9, 2, 5, 2, 3, 5, 3, 1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 0, 5, 9, 2, 5, 2, 3, 5, 3, 1, -1, -1, -1, -1 },
+	{ 0, 2, 3, 0, 3, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 2, 4, 2, 3, 4, 3, 1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 3, 10, 4, 3, 4, 5, 3, 5, 9, 3, 9, 2, -1, -1, -1, -1 },
+	{ 5, 9, 2, 5, 2, 3, 5, 3, 10, 5, 10, 8, 5, 8, 0, -1 },
+	{ 0, 2, 3, 0, 3, 10, 0, 10, 4, -1, -1, -1, -1, -1, -1, -1 },
+	{ 3, 10, 8, 3, 8, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 3, 11, 9, 3, 9, 8, 3, 8, 6, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 6, 3, 4, 3, 11, 4, 11, 9, 4, 9, 0, -1, -1, -1, -1 },
+	{ 0, 8, 6, 0, 6, 3, 0, 3, 11, 0, 11, 5, -1, -1, -1, -1 },
+	{ 3, 11, 5, 3, 5, 4, 3, 4, 6, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 10, 4, 3, 11, 9, 3, 9, 8, 3, 8, 6, -1, -1, -1, -1 },
+	{ 1, 10, 6, 1, 6, 3, 1, 3, 11, 1, 11, 9, 1, 9, 0, -1 },
+	{ 0, 8, 6, 0, 6, 3, 0, 3, 11, 0, 11, 5, 1, 10, 4, -1 },
+	{ 1, 10, 6, 1, 6, 3, 1, 3, 11, 1, 11, 5, -1, -1, -1, -1 },
+	{ 5, 9, 8, 5, 8, 6, 5, 6, 3, 5, 3, 1, -1, -1, -1, -1 },
+	{ 4, 6, 3, 4, 3, 1, 4, 1, 5, 4, 5, 9, 4, 9, 0, -1 },
+	{ 0, 8, 6, 0, 6, 3, 0, 3, 1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 6, 3, 4, 3, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 3, 10, 4, 3, 4, 5, 3, 5, 9, 3, 9, 8, 3, 8, 6, -1 },
+	{ 5, 9, 0, 3, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 8, 6, 0, 6, 3, 0, 3, 10, 0, 10, 4, -1, -1, -1, -1 },
+	{ 3, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 6, 10, 11, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 0, 6, 10, 11, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 9, 5, 6, 10, 11, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 9, 4, 9, 5, 6, 10, 11, 6, 11, 7, -1, -1, -1, -1 },
+	{ 1, 11, 7, 1, 7, 6, 1, 6, 4, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 11, 7, 1, 7, 6, 1, 6, 8, 1, 8, 0, -1, -1, -1, -1 },
+	{ 0, 9, 5, 1, 11, 7, 1, 7, 6, 1, 6, 4, -1, -1, -1, -1 },
+	{ 1, 11, 7, 1, 7, 6, 1, 6, 8, 1, 8, 9, 1, 9, 5, -1 },
+	{ 5, 7, 6, 5, 6, 10, 5, 10, 1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 0, 5, 7, 6, 5, 6, 10, 5, 10, 1, -1, -1, -1, -1 },
+	{ 0, 9, 7, 0, 7, 6, 0, 6, 10, 0, 10, 1, -1, -1, -1, -1 },
+	{ 4, 8, 9, 4, 9, 7, 4, 7, 6, 4, 6, 10, 4, 10, 1, -1 },
+	{ 5, 7, 6, 5, 6, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 5, 7, 6, 5, 6, 8, 5, 8, 0, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 9, 7, 0, 7, 6, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1 },
+	{ 6, 8, 9, 6, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 2, 8, 10, 2, 10, 11, 2, 11, 7, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 10, 11, 4, 11, 7, 4, 7, 2, 4, 2, 0, -1, -1, -1, -1 },
+	{ 0, 9, 5, 2, 8, 10, 2, 10, 11, 2, 11, 7, -1, -1, -1, -1 },
+	{ 2, 9, 5, 2, 5, 4, 2, 4, 10, 2, 10, 11, 2, 11, 7, -1 },
+	{ 1, 11, 7, 1, 7, 2, 1, 2, 8, 1, 8, 4, -1, -1, -1, -1 },
+	{ 1, 11, 7, 1, 7, 2, 1, 2, 0, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 9, 5, 1, 11, 7, 1, 7, 2, 1, 2, 8, 1, 8, 4, -1 },
+	{ 1, 11, 7, 1, 7, 2, 1, 2, 9, 1, 9, 5, -1, -1, -1, -1 },
+	{ 5, 7, 2, 5, 2, 8, 5, 8, 10, 5, 10, 1, -1, -1, -1, -1 },
+	{ 4, 10, 1, 4, 1, 5, 4, 5, 7, 4, 7, 2, 4, 2, 0, -1 },
+	{ 0, 9, 7, 0, 7, 2, 0, 2, 8, 0, 8, 10, 0, 10, 1, -1 },
+	{ 4, 10, 1, 2, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 2, 8, 4, 2, 4, 5, 2, 5, 7, -1, -1, -1, -1, -1, -1, -1 },
+	{ 5, 7, 2, 5, 2, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 9, 7, 0, 7, 2, 0, 2, 8, 0, 8, 4, -1, -1, -1, -1 },
+	{ 2, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 6, 10, 11, 6, 11, 9, 6, 9, 2, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 0, 6, 10, 11, 6, 11, 9, 6, 9, 2, -1, -1, -1, -1 },
+	{ 0, 2, 6, 0, 6, 10, 0, 10, 11, 0, 11, 5, -1, -1, -1, -1 },
+	{ 6, 10, 11, 6, 11, 5, 6, 5, 4, 6, 4, 8, 6, 8, 2, -1 },
+	{ 1, 11, 9, 1, 9, 2, 1, 2, 6, 1, 6, 4, -1, -1, -1, -1 },
+	{ 1, 11, 9, 1, 9, 2, 1, 2, 6, 1, 6, 8, 1, 8, 0, -1 },
+	{ 0, 2, 6, 0, 6, 4, 0, 4, 1, 0, 1, 11, 0, 11, 5, -1 },
+	{ 1, 11, 5, 6, 8, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 5, 9, 2, 5, 2, 6, 5, 6, 10, 5, 10, 1, -1, -1, -1, -1 },
+	{ 4, 8, 0, 5, 9, 2, 5, 2, 6, 5, 6, 10, 5, 10, 1, -1 },
+	{ 0, 2, 6, 0, 6, 10, 0, 10, 1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 8, 2, 4, 2, 6, 4, 6, 10, 4, 10, 1, -1, -1, -1, -1 },
+	{ 6, 4, 5, 6, 5, 9, 6, 9, 2, -1, -1, -1, -1, -1, -1, -1 },
+	{ 5, 9, 2, 5, 2, 6, 5, 6, 8, 5, 8, 0, -1, -1, -1, -1 },
+	{ 0, 2, 6, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 6, 8, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 8, 10, 11, 8, 11, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 10, 11, 4, 11, 9, 4, 9, 0, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 8, 10, 0, 10, 11, 0, 11, 5, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 10, 11, 4, 11, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 11, 9, 1, 9, 8, 1, 8, 4, -1, -1, -1, -1, -1, -1, -1 },
+	{ 1, 11, 9, 1, 9, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 8, 4, 0, 4, 1, 0, 1, 11, 0, 11, 5, -1, -1, -1, -1 },
+	{ 1, 11, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 5, 9, 8, 5, 8, 10, 5, 10, 1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 10, 1, 4, 1, 5, 4, 5, 9, 4, 9, 0, -1, -1, -1, -1 },
+	{ 0, 8, 10, 0, 10, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 4, 10, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 5, 9, 8, 5, 8, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 5, 9, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ 0, 8, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	{ -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+};
+
+enum class BlockOccupancy : uint8_t {
+	Empty,
+	Mixed,
+	Full
+};
+
+struct SurfaceBrick {
+	VoxelHashTable owned;                 // edge key -> vertices index, for edges whose lower end is in the brick
+	std::vector<XMFLOAT3> vertices;
+	std::vector<uint64_t> triangleEdges;  // three edge keys per triangle, owner step in the top bits
+	unsigned int firstVertex;
+
+	// Most bricks stay empty, so tables start small.
+	SurfaceBrick() : owned(0), firstVertex(0) {}
+};
+
+// The lattice of samples: sample s is the center of cell s - 1, so samples 0
+// and cells + 1 are the padding.
+struct SurfaceLattice {
+	const VoxelGrid* grid;
+	int cells;
+	int samples;        // cells + 2 per axis
+	int bricksPerAxis;
+	int smoothing;
+	float origin[3];    // position of sample 0
+	float size[3];      // cell size
+	std::vector<uint64_t> spread;          // MortonSplitBy3 of every cell coordinate
+	std::vector<BlockOccupancy> blocks;    // per aligned SurfaceBrickSize^3 block, empty if cells is smaller
+
+	uint64_t EdgeKey(int x, int y, int z, int axis) const {
+		return ((static_cast<uint64_t>(z) * samples + y) * samples + x) * 3 + axis;
+	}
+};
+
+static BlockOccupancy ClassifyWords(const uint64_t* words, size_t count)
+{
+	uint64_t any = 0, all = ~0ull;
+
+	for (size_t i = 0; i < count; ++i) {
+		any |= words[i];
+		all &= words[i];
+	}
+
+	return !any ? BlockOccupancy::Empty : all == ~0ull ? BlockOccupancy::Full : BlockOccupancy::Mixed;
+}
+
+static void ClassifyBlocks(SurfaceLattice& lattice)
+{
+	if (lattice.cells < SurfaceBrickSize)
+		return;
+
+	// An aligned block is a contiguous run of Morton codes.
+	const int blocksPerAxis = lattice.cells / SurfaceBrickSize;
+	const size_t wordsPerBlock = SurfaceBrickSize * SurfaceBrickSize * SurfaceBrickSize / 64;
+
+	lattice.blocks.resize(static_cast<size_t>(blocksPerAxis) * blocksPerAxis * blocksPerAxis);
+
+	for (int z = 0; z < blocksPerAxis; ++z) {
+		for (int y = 0; y < blocksPerAxis; ++y) {
+			for (int x = 0; x < blocksPerAxis; ++x) {
+				const uint64_t code = EncodeMorton3(x, y, z);
+				lattice.blocks[(static_cast<size_t>(z) * blocksPerAxis + y) * blocksPerAxis + x] =
+					ClassifyWords(&lattice.grid->bits[static_cast<size_t>(code * wordsPerBlock)], wordsPerBlock);
+			}
+		}
+	}
+}
+
+// Whether the field is constant over cells [begin, end] per axis, which cover
+// a brick's samples and their filter. Cells outside the grid are empty.
+static bool IsConstantRegion(const SurfaceLattice& lattice, const int begin[3], const int end[3])
+{
+	if (lattice.blocks.empty())
+		return false;
+
+	const int blocksPerAxis = lattice.cells / SurfaceBrickSize;
+	bool padded = false;
+	int first[3], last[3];
+
+	for (int axis = 0; axis < 3; ++axis) {
+		padded |= begin[axis] < 0 || end[axis] >= lattice.cells;
+		first[axis] = std::max(begin[axis], 0) / SurfaceBrickSize;
+		last[axis] = std::min(end[axis], lattice.cells - 1) / SurfaceBrickSize;
+	}
+
+	bool empty = true, full = !padded;
+
+	for (int z = first[2]; z <= last[2]; ++z) {
+		for (int y = first[1]; y <= last[1]; ++y) {
+			for (int x = first[0]; x <= last[0]; ++x) {
+				const BlockOccupancy block = lattice.blocks[(static_cast<size_t>(z) * blocksPerAxis + y) * blocksPerAxis + x];
+				empty &= block == BlockOccupancy::Empty;
+				full &= block == BlockOccupancy::Full;
+			}
+		}
+	}
+
+	return empty || full;
+}
+
+// Box-filters one axis of a size[0] x size[1] x size[2] array (x fastest),
+// shrinking that axis by 2 * radius. Along x a running sum slides over each
+// row; along y and z whole rows are added, which vectorizes.
+template <typename In, typename Out>
+static void BoxSum(const std::vector<In>& in, const int size[3], int axis, int radius, std::vector<Out>& out)
+{
+	int outSize[3] = { size[0], size[1], size[2] };
+	outSize[axis] -= 2 * radius;
+
+	out.assign(static_cast<size_t>(outSize[0]) * outSize[1] * outSize[2], 0);
+
+	if (axis == 0) {
+		for (size_t row = 0; row < static_cast<size_t>(outSize[1]) * outSize[2]; ++row) {
+			const In* p = &in[row * size[0]];
+			Out* q = &out[row * outSize[0]];
+
+			Out sum = 0;
+			for (int k = 0; k < 2 * radius; ++k) {
+				sum += p[k];
+			}
+			for (int x = 0; x < outSize[0]; ++x) {
+				sum += p[x + 2 * radius];
+				q[x] = sum;
+				sum -= p[x];
+			}
+		}
+		return;
+	}
+
+	const size_t stride = axis == 1 ? size[0] : static_cast<size_t>(size[0]) * size[1];
+
+	for (int z = 0; z < outSize[2]; ++z) {
+		for (int y = 0; y < outSize[1]; ++y) {
+			const In* p = &in[(static_cast<size_t>(z) * size[1] + y) * size[0]];
+			Out* q = &out[(static_cast<size_t>(z) * outSize[1] + y) * outSize[0]];
+
+			for (int k = 0; k <= 2 * radius; ++k) {
+				const In* row = p + k * stride;
+				for (int x = 0; x < outSize[0]; ++x) {
+					q[x] += row[x];
+				}
+			}
+		}
+	}
+}
+
+static void ExtractBrick(const SurfaceLattice& lattice, int index, SurfaceBrick& brick)
+{
+	const int r = lattice.smoothing;
+	const int cubes = lattice.samples - 1;
+	const int brickCoords[3] = {
+		index % lattice.bricksPerAxis,
+		index / lattice.bricksPerAxis % lattice.bricksPerAxis,
+		index / lattice.bricksPerAxis / lattice.bricksPerAxis
+	};
+
+	// The brick's cubes [origin, origin + count) use samples
+	// [origin, origin + count], which filter cells [origin - 1 - r, origin + count - 1 + r].
+	int origin[3], count[3], cellBegin[3], cellEnd[3], loaded[3];
+	for (int axis = 0; axis < 3; ++axis) {
+		origin[axis] = brickCoords[axis] * SurfaceBrickSize;
+		count[axis] = std::min(SurfaceBrickSize, cubes - origin[axis]);
+		cellBegin[axis] = origin[axis] - 1 - r;
+		cellEnd[axis] = origin[axis] + count[axis] - 1 + r;
+		loaded[axis] = cellEnd[axis] - cellBegin[axis] + 1;
+	}
+
+	if (IsConstantRegion(lattice, cellBegin, cellEnd))
+		return;
+
+	std::vector<uint8_t> occupancy(static_cast<size_t>(loaded[0]) * loaded[1] * loaded[2]);
+	size_t occupied = 0;
+
+	for (int z = 0; z < loaded[2]; ++z) {
+		const int cz = cellBegin[2] + z;
+		for (int y = 0; y < loaded[1]; ++y) {
+			const int cy = cellBegin[1] + y;
+			uint8_t* row = &occupancy[(static_cast<size_t>(z) * loaded[1] + y) * loaded[0]];
+
+			if (cz < 0 || cz >= lattice.cells || cy < 0 || cy >= lattice.cells)
+				continue;
+
+			const uint64_t rest = lattice.spread[cy] << 1 | lattice.spread[cz] << 2;
+			for (int x = 0; x < loaded[0]; ++x) {
+				const int cx = cellBegin[0] + x;
+				if (cx >= 0 && cx < lattice.cells && lattice.grid->Test(rest | lattice.spread[cx])) {
+					row[x] = 1;
+					++occupied;
+				}
+			}
+		}
+	}
+
+	if (occupied == 0)
+		return;
+
+	// Separable box filter down to the (count + 1)^3 samples, as sums over
+	// the window; a sample is inside if more than half the window is occupied.
+	std::vector<uint16_t> sums;
+
+	if (r == 0) {
+		sums.assign(occupancy.begin(), occupancy.end());
+	}
+	else {
+		std::vector<uint16_t> sumX, sumY;
+		int size[3] = { loaded[0], loaded[1], loaded[2] };
+
+		BoxSum(occupancy, size, 0, r, sumX);
+		size[0] -= 2 * r;
+		BoxSum(sumX, size, 1, r, sumY);
+		size[1] -= 2 * r;
+		BoxSum(sumY, size, 2, r, sums);
+	}
+
+	const int window = (2 * r + 1) * (2 * r + 1) * (2 * r + 1);
+	const float scale = 1.f / window;
+	const int sx = count[0] + 1, sy = count[1] + 1;
+
+	std::vector<uint8_t> inside(sums.size());
+	for (size_t i = 0; i < sums.size(); ++i) {
+		inside[i] = 2 * sums[i] > window;
+	}
+
+	auto sampleIndex = [sx, sy](int x, int y, int z) {
+		return (static_cast<size_t>(z) * sy + y) * sx + x;
+	};
+
+	for (int z = 0; z < count[2]; ++z) {
+		for (int y = 0; y < count[1]; ++y) {
+			// A cube's case is built from the columns of four samples at its
+			// two x ends, column bits at 0, 2, 4, 6 for (y, z) offsets, so
+			// the right column is the next cube's left.
+			const uint8_t* rows[4] = {
+				&inside[sampleIndex(0, y, z)], &inside[sampleIndex(0, y + 1, z)],
+				&inside[sampleIndex(0, y, z + 1)], &inside[sampleIndex(0, y + 1, z + 1)]
+			};
+			auto column = [&rows](int x) {
+				return rows[0][x] | rows[1][x] << 2 | rows[2][x] << 4 | rows[3][x] << 6;
+			};
+
+			int left = column(0);
+
+			for (int x = 0; x < count[0]; ++x) {
+				const int right = column(x + 1);
+				const int cubeCase = left | right << 1;
+				left = right;
+
+				if (cubeCase == 0 || cubeCase == 0xff)
+					continue;
+
+				float values[8];
+				for (int corner = 0; corner < 8; ++corner) {
+					values[corner] = sums[sampleIndex(x + (corner & 1), y + (corner >> 1 & 1), z + (corner >> 2 & 1))] * scale;
+				}
+
+				const int8_t* edges = TriangleTable[cubeCase];
+
+				for (int i = 0; edges[i] >= 0; ++i) {
+					const int edge = edges[i];
+					const int axis = edge >> 2;
+					const int corner = EdgeCorners[edge];
+					const int lower[3] = {
+						origin[0] + x + (corner & 1),
+						origin[1] + y + (corner >> 1 & 1),
+						origin[2] + z + (corner >> 2 & 1)
+					};
+					const uint64_t key = lattice.EdgeKey(lower[0], lower[1], lower[2], axis);
+
+					// Past the brick's last cube the edge belongs to the next
+					// brick, except past the lattice's last one.
+					uint64_t ownerStep = 0;
+					for (int a = 0; a < 3; ++a) {
+						if (lower[a] >= origin[a] + SurfaceBrickSize && brickCoords[a] + 1 < lattice.bricksPerAxis) {
+							ownerStep |= 1ull << a;
+						}
+					}
+
+					brick.triangleEdges.push_back(key | ownerStep << OwnerStepShift);
+
+					if (ownerStep)
+						continue;
+
+					bool inserted;
+					brick.owned.FindOrInsert(key, static_cast<uint32_t>(brick.vertices.size()), inserted);
+					if (!inserted)
+						continue;
+
+					const float f0 = values[corner];
+					const float f1 = values[corner | 1 << axis];
+					const float t = (0.5f - f0) / (f1 - f0);
+
+					float p[3];
+					for (int a = 0; a < 3; ++a) {
+						p[a] = lattice.origin[a] + (lower[a] + (a == axis ? t : 0.f)) * lattice.size[a];
+					}
+					brick.vertices.push_back(XMFLOAT3(p[0], p[1], p[2]));
+				}
+			}
+		}
+	}
+}
+
+void BuildVoxelGridSurface(const VoxelGrid& grid, VoxelMesh& mesh, int smoothing)
+{
+	SurfaceLattice lattice;
+	lattice.grid = &grid;
+	lattice.cells = 1 << grid.depth;
+	lattice.samples = lattice.cells + 2;
+	lattice.bricksPerAxis = (lattice.samples - 1 + SurfaceBrickSize - 1) / SurfaceBrickSize;
+	lattice.smoothing = std::min(std::max(smoothing, 0), MaxSurfaceSmoothing);
+
+	const float* pMin = &grid.boundingBox.Min.x;
+	const float* pMax = &grid.boundingBox.Max.x;
+	for (int axis = 0; axis < 3; ++axis) {
+		lattice.size[axis] = (pMax[axis] - pMin[axis]) / lattice.cells;
+		lattice.origin[axis] = pMin[axis] - 0.5f * lattice.size[axis];
+	}
+
+	lattice.spread.resize(lattice.cells);
+	for (int i = 0; i < lattice.cells; ++i) {
+		lattice.spread[i] = MortonSplitBy3(i);
+	}
+
+	ClassifyBlocks(lattice);
+
+	const int brickCount = lattice.bricksPerAxis * lattice.bricksPerAxis * lattice.bricksPerAxis;
+	std::vector<SurfaceBrick> bricks(brickCount);
+
+	concurrency::parallel_for(0, brickCount, [&](int i) {
+		ExtractBrick(lattice, i, bricks[i]);
+	});
+
+	// Bricks are appended in order, so the mesh does not depend on scheduling.
+	std::vector<size_t> firstIndices(brickCount);
+	size_t vertexCount = mesh.vertices.size(), indexCount = mesh.indices.size();
+
+	for (int i = 0; i < brickCount; ++i) {
+		bricks[i].firstVertex = static_cast<unsigned int>(vertexCount);
+		firstIndices[i] = indexCount;
+		vertexCount += bricks[i].vertices.size();
+		indexCount += bricks[i].triangleEdges.size();
+	}
+
+	mesh.vertices.reserve(vertexCount);
+	for (const auto& brick : bricks) {
+		mesh.vertices.insert(mesh.vertices.end(), brick.vertices.begin(), brick.vertices.end());
+	}
+
+	// Every edge is resolved through the brick that owns it, which is done
+	// by now, so the bricks can be read in parallel.
+	mesh.indices.resize(indexCount);
+
+	concurrency::parallel_for(0, brickCount, [&](int i) {
+		unsigned int* indices = mesh.indices.data() + firstIndices[i];
+
+		for (uint64_t edge : bricks[i].triangleEdges) {
+			const int step = static_cast<int>(edge >> OwnerStepShift);
+			const int owner = i + (step & 1) + (step >> 1 & 1) * lattice.bricksPerAxis + (step >> 2) * lattice.bricksPerAxis * lattice.bricksPerAxis;
+			*indices++ = bricks[owner].firstVertex + bricks[owner].owned.Find(edge & EdgeKeyMask);
+		}
+	});
+}
+
+void BuildLinearOctreeSurface(const LinearOctree* octree, VoxelMesh& mesh, int smoothing)
+{
+	if (octree->depth < 1 || octree->depth > VoxelGrid::MaxDepth) {
+		BuildLinearOctreeMesh(octree, mesh);
+		return;
+	}
+
+	VoxelGrid grid;
+	grid.Resize(octree->boundingBox, octree->depth);
+	FillVoxelGrid(grid, octree);
+
+	BuildVoxelGridSurface(grid, mesh, smoothing);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "LinearOctree.h"
+#include "VoxelGrid.h"
+#include "VoxelMesher.h"
+
+// Smooth proxy surfaces of voxel sets by marching cubes. The field is each
+// cell's occupancy sampled at its center, box-filtered over (2 smoothing + 1)^3
+// cells, and the surface is its 0.5 isosurface. One empty cell is padded
+// around the grid, so the surface always closes.
+//
+// Bricks of 32^3 cubes are extracted in parallel, and bricks whose cells are
+// all empty or all full are skipped a cache line at a time. Every vertex lies
+// on one lattice edge and is shared by all triangles on that edge, across
+// bricks too, so the mesh is welded and watertight. Ambiguous faces always
+// separate the occupied corners, the same way from both sides.
+
+const int MaxSurfaceSmoothing = 8;
+
+// smoothing is clamped to [0, MaxSurfaceSmoothing]. 0 keeps the cells'
+// staircase, cut at 45 degrees; 1 or 2 round it off. Appends to mesh, wound
+// like BuildVoxelGridMesh.
+void BuildVoxelGridSurface(const VoxelGrid& grid, VoxelMesh& mesh, int smoothing = 1);
+
+// Rasterizes the octree into a VoxelGrid and extracts that. Octrees deeper
+// than VoxelGrid::MaxDepth fall back to BuildLinearOctreeMesh.
+void BuildLinearOctreeSurface(const LinearOctree* octree, VoxelMesh& mesh, int smoothing = 1);
@@ -0,0 +1,299 @@
+#include "MeshExport.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <ppl.h>
+
+using namespace DirectX;
+
+// Lines formatted by one task, and tasks per fwrite. A batch of OBJ text is a
+// few tens of MB at most, however large the mesh.
+static const size_t ObjLinesPerTask = 16384;
+static const size_t ObjTasksPerBatch = 64;
+
+// Same text as printf("%f"): the product of a float and 1e6 is exact in a
+// double, so rounding it half to even matches the exact decimal rounding.
+static char* formatFixed(char* out, float value)
+{
+	const double scaled = fabs(static_cast<double>(value)) * 1e6;
+
+	if (!(scaled < 1e18)) {
+		return out + sprintf_s(out, 64, "%f", value);
+	}
+
+	if (std::signbit(value)) {
+		*out++ = '-';
+	}
+
+	const uint64_t fixed = static_cast<uint64_t>(nearbyint(scaled));
+	uint64_t integer = fixed / 1000000;
+	uint32_t fraction = static_cast<uint32_t>(fixed % 1000000);
+
+	char digits[20];
+	int count = 0;
+	do {
+		digits[count++] = static_cast<char>('0' + integer % 10);
+		integer /= 10;
+	} while (integer);
+
+	while (count) {
+		*out++ = digits[--count];
+	}
+
+	*out++ = '.';
+	for (int i = 5; i >= 0; --i) {
+		out[i] = static_cast<char>('0' + fraction % 10);
+		fraction /= 10;
+	}
+
+	return out + 6;
+}
+
+static char* formatUnsigned(char* out, uint32_t value)
+{
+	char digits[10];
+	int count = 0;
+	do {
+		digits[count++] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while (value);
+
+	while (count) {
+		*out++ = digits[--count];
+	}
+
+	return out;
+}
+
+// "v x y z" for vertex line < vertexCount, then "f a b c" with one-based indices.
+static void formatObjLines(const VoxelMesh& mesh, size_t first, size_t last, std::string& text)
+{
+	const size_t vertexCount = mesh.vertices.size();
+
+	text.resize((last - first) * 64);
+	char* out = &text[0];
+
+	for (size_t line = first; line < last; ++line) {
+		// A line is at most 3 * 48 bytes; grow the buffer before one could overflow it.
+		if (static_cast<size_t>(out - &text[0]) + 192 > text.size()) {
+			const size_t used = out - &text[0];
+			text.resize(std::max(text.size() * 2, used + 192));
+			out = &text[0] + used;
+		}
+
+		if (line < vertexCount) {
+			const XMFLOAT3& v = mesh.vertices[line];
+			*out++ = 'v';
+			*out++ = ' ';
+			out = formatFixed(out, v.x);
+			*out++ = ' ';
+			out = formatFixed(out, v.y);
+			*out++ = ' ';
+			out = formatFixed(out, v.z);
+		}
+		else {
+			const unsigned int* triangle = &mesh.indices[3 * (line - vertexCount)];
+			*out++ = 'f';
+			*out++ = ' ';
+			out = formatUnsigned(out, triangle[0] + 1);
+			*out++ = ' ';
+			out = formatUnsigned(out, triangle[1] + 1);
+			*out++ = ' ';
+			out = formatUnsigned(out, triangle[2] + 1);
+		}
+		*out++ = '\n';
+	}
+
+	text.resize(out - &text[0]);
+}
+
+bool WriteObjMesh(const char* filename, const VoxelMesh& mesh)
+{
+	FILE* fp = nullptr;
+
+	fopen_s(&fp, filename, "wb");
+	if (!fp)
+		return false;
+
+	const size_t lineCount = mesh.vertices.size() + mesh.indices.size() / 3;
+	const size_t linesPerBatch = ObjLinesPerTask * ObjTasksPerBatch;
+
+	std::vector<std::string> texts(ObjTasksPerBatch);
+	bool written = true;
+
+	for (size_t batch = 0; batch < lineCount && written; batch += linesPerBatch) {
+		const size_t batchEnd = std::min(batch + linesPerBatch, lineCount);
+		const size_t taskCount = (batchEnd - batch + ObjLinesPerTask - 1) / ObjLinesPerTask;
+
+		concurrency::parallel_for(size_t(0), taskCount, [&](size_t task) {
+			const size_t first = batch + task * ObjLinesPerTask;
+			formatObjLines(mesh, first, std::min(first + ObjLinesPerTask, batchEnd), texts[task]);
+		});
+
+		for (size_t task = 0; task < taskCount && written; ++task) {
+			written = fwrite(texts[task].data(), 1, texts[task].size(), fp) == texts[task].size();
+		}
+	}
+
+	return fclose(fp) == 0 && written;
+}
+
+bool WritePlyMesh(const char* filename, const VoxelMesh& mesh)
+{
+	FILE* fp = nullptr;
+
+	fopen_s(&fp, filename, "wb");
+	if (!fp)
+		return false;
+
+	const size_t triangleCount = mesh.indices.size() / 3;
+
+	fprintf(fp,
+		"ply\n"
+		"format binary_little_endian 1.0\n"
+		"element vertex %zu\n"
+		"property float x\n"
+		"property float y\n"
+		"property float z\n"
+		"element face %zu\n"
+		"property list uchar uint vertex_indices\n"
+		"end_header\n",
+		mesh.vertices.size(), triangleCount);
+
+	bool written = fwrite(mesh.vertices.data(), sizeof(XMFLOAT3), mesh.vertices.size(), fp) == mesh.vertices.size();
+
+	// Each face is a count byte and three indices, 13 bytes with no padding.
+	const size_t FaceBytes = 1 + 3 * sizeof(uint32_t);
+	const size_t facesPerChunk = 65536;
+	std::vector<uint8_t> faces;
+
+	for (size_t first = 0; first < triangleCount && written; first += facesPerChunk) {
+		const size_t last = std::min(first + facesPerChunk, triangleCount);
+
+		faces.resize((last - first) * FaceBytes);
+		uint8_t* out = faces.data();
+
+		for (size_t t = first; t < last; ++t) {
+			*out = 3;
+			memcpy(out + 1, &mesh.indices[3 * t], 3 * sizeof(uint32_t));
+			out += FaceBytes;
+		}
+
+		written = fwrite(faces.data(), 1, faces.size(), fp) == faces.size();
+	}
+
+	return fclose(fp) == 0 && written;
+}
+
+bool WriteGlbMesh(const char* filename, const VoxelMesh& mesh)
+{
+	const uint32_t positionBytes = static_cast<uint32_t>(mesh.vertices.size() * sizeof(XMFLOAT3));
+	const uint32_t indexBytes = static_cast<uint32_t>(mesh.indices.size() * sizeof(uint32_t));
+	const uint32_t binaryBytes = positionBytes + indexBytes;
+
+	std::string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"OctreeVoxelizerCmd\"}";
+
+	// Accessors may not be empty, so an empty mesh is a scene with no nodes.
+	if (mesh.vertices.empty() || mesh.indices.empty()) {
+		json += ",\"scene\":0,\"scenes\":[{\"nodes\":[]}]}";
+	}
+	else {
+		float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		for (const auto& vertex : mesh.vertices) {
+			const float* p = &vertex.x;
+			for (int axis = 0; axis < 3; ++axis) {
+				lo[axis] = std::min(lo[axis], p[axis]);
+				hi[axis] = std::max(hi[axis], p[axis]);
+			}
+		}
+
+		char text[1024];
+		sprintf_s(text,
+			",\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],"
+			"\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0},\"indices\":1}]}],"
+			"\"buffers\":[{\"byteLength\":%u}],"
+			"\"bufferViews\":["
+			"{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%u,\"target\":34962},"
+			"{\"buffer\":0,\"byteOffset\":%u,\"byteLength\":%u,\"target\":34963}],"
+			"\"accessors\":["
+			"{\"bufferView\":0,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC3\",\"min\":[%.9g,%.9g,%.9g],\"max\":[%.9g,%.9g,%.9g]},"
+			"{\"bufferView\":1,\"componentType\":5125,\"count\":%zu,\"type\":\"SCALAR\"}]}",
+			binaryBytes, positionBytes, positionBytes, indexBytes,
+			mesh.vertices.size(), lo[0], lo[1], lo[2], hi[0], hi[1], hi[2],
+			mesh.indices.size());
+		json += text;
+	}
+
+	// Chunks are 4-byte aligned. JSON is padded with spaces; positions and
+	// indices are whole 4-byte values already.
+	json.append((4 - json.size() % 4) % 4, ' ');
+
+	const bool hasBinary = !mesh.vertices.empty() && !mesh.indices.empty();
+	const uint32_t jsonBytes = static_cast<uint32_t>(json.size());
+	const uint32_t totalBytes = 12 + 8 + jsonBytes + (hasBinary ? 8 + binaryBytes : 0);
+
+	const uint32_t header[5] = {
+		0x46546c67, // "glTF"
+		2,
+		totalBytes,
+		jsonBytes,
+		0x4e4f534a  // "JSON"
+	};
+	const uint32_t binaryHeader[2] = { binaryBytes, 0x004e4942 }; // "BIN"
+
+	FILE* fp = nullptr;
+
+	fopen_s(&fp, filename, "wb");
+	if (!fp)
+		return false;
+
+	bool written = fwrite(header, sizeof(header), 1, fp) == 1
+		&& fwrite(json.data(), 1, json.size(), fp) == json.size();
+
+	if (hasBinary && written) {
+		written = fwrite(binaryHeader, sizeof(binaryHeader), 1, fp) == 1
+			&& fwrite(mesh.vertices.data(), 1, positionBytes, fp) == positionBytes
+			&& fwrite(mesh.indices.data(), 1, indexBytes, fp) == indexBytes;
+	}
+
+	return fclose(fp) == 0 && written;
+}
+
+bool WriteMesh(const char* filename, const VoxelMesh& mesh, MeshFormat format)
+{
+	switch (format) {
+	case MeshFormat::Ply:
+		return WritePlyMesh(filename, mesh);
+	case MeshFormat::Glb:
+		return WriteGlbMesh(filename, mesh);
+	default:
+		return WriteObjMesh(filename, mesh);
+	}
+}
+
+bool WriteBoxes(const char* filename, const std::vector<BoundingBox3D>& boxes, MeshFormat format)
+{
+	VoxelMesh mesh;
+	BuildBoxMesh(boxes, mesh);
+
+	return WriteMesh(filename, mesh, format);
+}
+
+const char* MeshFormatExtension(MeshFormat format)
+{
+	switch (format) {
+	case MeshFormat::Ply:
+		return "ply";
+	case MeshFormat::Glb:
+		return "glb";
+	default:
+		return "obj";
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+#include "BoundingBox3D.h"
+#include "VoxelMesher.h"
+
+// Writers for voxel meshes. OBJ text is formatted in parallel, a batch of
+// lines per task, and written with one fwrite per batch. PLY and GLB are
+// binary little-endian and written straight from the vertex and index arrays.
+// All return false if the file cannot be opened or written.
+
+enum class MeshFormat {
+	Obj,
+	Ply, // binary_little_endian 1.0
+	Glb  // glTF 2.0 binary container, one triangle primitive
+};
+
+bool WriteObjMesh(const char* filename, const VoxelMesh& mesh);
+bool WritePlyMesh(const char* filename, const VoxelMesh& mesh);
+bool WriteGlbMesh(const char* filename, const VoxelMesh& mesh);
+
+bool WriteMesh(const char* filename, const VoxelMesh& mesh, MeshFormat format);
+
+// Meshes every box with BuildBoxMesh and writes it, e.g. for boxGeometries or
+// BinaryTree::boundingBoxes.
+bool WriteBoxes(const char* filename, const std::vector<BoundingBox3D>& boxes, MeshFormat format);
+
+// "obj", "ply" or "glb".
+const char* MeshFormatExtension(MeshFormat format);
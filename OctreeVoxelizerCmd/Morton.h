@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+// 64-bit Morton codes hold 21 bits per axis. x goes to bit 0, y to bit 1 and
+// z to bit 2 of every triplet, so the low three bits of a code are the octant
+// of the cell inside its parent.
+
+const int MortonBitsPerAxis = 21;
+
+inline uint64_t MortonSplitBy3(uint32_t a)
+{
+	uint64_t x = a & 0x1fffff;
+	x = (x | x << 32) & 0x1f00000000ffffull;
+	x = (x | x << 16) & 0x1f0000ff0000ffull;
+	x = (x | x << 8) & 0x100f00f00f00f00full;
+	x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+	x = (x | x << 2) & 0x1249249249249249ull;
+	return x;
+}
+
+inline uint32_t MortonCompactBy3(uint64_t x)
+{
+	x &= 0x1249249249249249ull;
+	x = (x ^ (x >> 2)) & 0x10c30c30c30c30c3ull;
+	x = (x ^ (x >> 4)) & 0x100f00f00f00f00full;
+	x = (x ^ (x >> 8)) & 0x1f0000ff0000ffull;
+	x = (x ^ (x >> 16)) & 0x1f00000000ffffull;
+	x = (x ^ (x >> 32)) & 0x1fffff;
+	return static_cast<uint32_t>(x);
+}
+
+inline uint64_t EncodeMorton3(uint32_t x, uint32_t y, uint32_t z)
+{
+	return MortonSplitBy3(x) | (MortonSplitBy3(y) << 1) | (MortonSplitBy3(z) << 2);
+}
+
+inline void DecodeMorton3(uint64_t code, uint32_t* x, uint32_t* y, uint32_t* z)
+{
+	*x = MortonCompactBy3(code);
+	*y = MortonCompactBy3(code >> 1);
+	*z = MortonCompactBy3(code >> 2);
+}
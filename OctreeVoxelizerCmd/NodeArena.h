@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Bump allocator for tree nodes, owned by the tree. Nodes are placed in blocks
+// of FirstBlockSize, 2 * FirstBlockSize, 4 * FirstBlockSize, ... nodes, so a
+// node index maps to its block with a log2 and no block table has to move.
+// New is safe to call from several tasks at once; only the first allocation
+// in a block takes the lock.
+//
+// Nodes are never destroyed one by one: Reset releases all of them in O(1)
+// and keeps the blocks for the next build, so T must be trivially destructible.
+
+template <typename T>
+class NodeArena {
+	static_assert(std::is_trivially_destructible<T>::value, "NodeArena releases nodes without running destructors");
+
+public:
+	static const size_t FirstBlockSize = 256;
+
+	NodeArena() : next(0) {
+		for (auto& block : blocks) {
+			block.store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	~NodeArena() {
+		for (auto& block : blocks) {
+			::operator delete(block.load(std::memory_order_relaxed));
+		}
+	}
+
+	NodeArena(const NodeArena&) = delete;
+	NodeArena& operator=(const NodeArena&) = delete;
+
+	template <typename... Args>
+	T* New(Args&&... args) {
+		const size_t index = next.fetch_add(1, std::memory_order_relaxed);
+		return new (Slot(index)) T(std::forward<Args>(args)...);
+	}
+
+	// Forgets every node. Not safe while another thread is in New.
+	void Reset() { next.store(0, std::memory_order_relaxed); }
+
+	size_t Size() const { return next.load(std::memory_order_relaxed); }
+
+	size_t CapacityBytes() const {
+		size_t bytes = 0;
+		for (int block = 0; block < MaxBlocks; ++block) {
+			if (blocks[block].load(std::memory_order_relaxed))
+				bytes += BlockSize(block) * sizeof(T);
+		}
+		return bytes;
+	}
+
+private:
+	static const int MaxBlocks = 48;
+
+	static size_t BlockSize(int block) { return FirstBlockSize << block; }
+
+	// Block k starts at node FirstBlockSize * (2^k - 1).
+	void* Slot(size_t index) {
+		size_t scaled = index / FirstBlockSize + 1;
+		int block = 0;
+		while (scaled >>= 1) {
+			++block;
+		}
+
+		T* storage = blocks[block].load(std::memory_order_acquire);
+		if (!storage) {
+			storage = AllocateBlock(block);
+		}
+
+		return storage + (index - FirstBlockSize * ((size_t(1) << block) - 1));
+	}
+
+	T* AllocateBlock(int block) {
+		std::lock_guard<std::mutex> lock(blockMutex);
+
+		T* storage = blocks[block].load(std::memory_order_relaxed);
+		if (!storage) {
+			storage = static_cast<T*>(::operator new(BlockSize(block) * sizeof(T)));
+			blocks[block].store(storage, std::memory_order_release);
+		}
+
+		return storage;
+	}
+
+	std::atomic<T*> blocks[MaxBlocks];
+	std::atomic<size_t> next;
+	std::mutex blockMutex;
+};
@@ -0,0 +1,106 @@
+#include "ObjVoxelStream.h"
+
+#include <algorithm>
+#include <cassert>
+#include <ppl.h>
+
+#include "TriangleVoxelizer.h"
+#include "VoxelGrid.h"
+
+using namespace DirectX;
+
+static const size_t PointsPerTask = 4096;
+
+void ObjVoxelStream::AddVertex(float x, float y, float z)
+{
+	boundingBox.AddPoint(XMFLOAT3(x, y, z));
+
+	positions.push_back(x);
+	positions.push_back(y);
+	positions.push_back(z);
+}
+
+void ObjVoxelStream::AddTriangle(int a, int b, int c)
+{
+	const long long count = static_cast<long long>(VertexCount());
+	const int corners[3] = { a, b, c };
+	long long fixed[3];
+
+	// Relative indices count back from the vertices read so far, as tinyobj's
+	// LoadObj resolves them.
+	for (int k = 0; k < 3; ++k) {
+		fixed[k] = corners[k] > 0 ? corners[k] - 1 : count + corners[k];
+
+		if (corners[k] == 0 || fixed[k] < 0) {
+			++droppedTriangles;
+			return;
+		}
+	}
+
+	for (int k = 0; k < 3; ++k) {
+		indices.push_back(static_cast<unsigned int>(fixed[k]));
+	}
+}
+
+LinearOctree* createLinearOctree(const ObjVoxelStream& stream, int depth)
+{
+	assert(depth > 0 && depth <= LinearOctree::MaxDepth);
+
+	LinearOctree* octree = new LinearOctree();
+	octree->depth = depth;
+	octree->boundingBox = stream.boundingBox;
+
+	const XMFLOAT3* points = reinterpret_cast<const XMFLOAT3*>(stream.positions.data());
+	std::vector<uint64_t> codes(stream.VertexCount());
+
+	concurrency::parallel_for(size_t(0), (codes.size() + PointsPerTask - 1) / PointsPerTask, [&](size_t task) {
+		const size_t end = std::min((task + 1) * PointsPerTask, codes.size());
+		for (size_t i = task * PointsPerTask; i < end; ++i) {
+			codes[i] = octree->PointCode(points[i]);
+		}
+	});
+
+	SortLeafCodes(codes, depth);
+	BuildLinearOctreeLevels(octree, codes);
+
+	return octree;
+}
+
+// The stream's triangles, less those with an index that still points past
+// the last vertex; storage holds the copy if any had to be dropped.
+static const std::vector<unsigned int>& CompleteTriangles(const ObjVoxelStream& stream, std::vector<unsigned int>& storage)
+{
+	assert(stream.keepTriangles);
+
+	const size_t vertexCount = stream.VertexCount();
+
+	if (std::none_of(stream.indices.begin(), stream.indices.end(), [vertexCount](unsigned int i) { return i >= vertexCount; }))
+		return stream.indices;
+
+	storage.reserve(stream.indices.size());
+	for (size_t t = 0; t + 2 < stream.indices.size(); t += 3) {
+		if (stream.indices[t] < vertexCount && stream.indices[t + 1] < vertexCount && stream.indices[t + 2] < vertexCount) {
+			storage.insert(storage.end(), stream.indices.begin() + t, stream.indices.begin() + t + 3);
+		}
+	}
+
+	return storage;
+}
+
+LinearOctree* createLinearOctreeFromTriangles(const ObjVoxelStream& stream, int depth, bool conservative)
+{
+	std::vector<unsigned int> storage;
+
+	return createLinearOctreeFromTriangles(stream.positions, CompleteTriangles(stream, storage), depth, conservative);
+}
+
+LinearOctree* createSolidLinearOctree(const ObjVoxelStream& stream, int depth)
+{
+	std::vector<unsigned int> storage;
+
+	VoxelGrid grid;
+	grid.Resize(stream.boundingBox, depth);
+	VoxelizeTrianglesSolid(grid, stream.positions, CompleteTriangles(stream, storage));
+
+	return createLinearOctreeFromGrid(grid);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "BoundingBox3D.h"
+#include "LinearOctree.h"
+
+// Voxelization fed by a streaming OBJ parse instead of a loaded attrib_t.
+// tinyobj's LoadObjWithCallback hands over one vertex or face at a time: a
+// vertex grows the bounding box and is appended to one compact xyz array, and
+// a face, if triangles are kept, is fanned into absolute vertex indices.
+// Colors, normals, texcoords, shapes and vertex pointers are never stored.
+//
+// Leaf codes are relative to the final box, so binning starts once the last
+// vertex is in; the box pass is done by then, and the codes of the array are
+// computed in parallel.
+
+class ObjVoxelStream {
+public:
+	BoundingBox3D boundingBox;
+	std::vector<float> positions;      // xyz per vertex, as attrib_t::vertices
+	std::vector<unsigned int> indices; // three per triangle, if keepTriangles
+	bool keepTriangles;
+	size_t droppedTriangles;           // with a zero index, or one before the first vertex
+
+	explicit ObjVoxelStream(bool keepTriangles = false)
+		: keepTriangles(keepTriangles), droppedTriangles(0) {}
+
+	size_t VertexCount() const { return positions.size() / 3; }
+
+	void AddVertex(float x, float y, float z);
+
+	// Corners as written in the file: from 1, or negative back from the last
+	// vertex. Positive indices may refer to vertices still to come.
+	void AddTriangle(int a, int b, int c);
+};
+
+// The octree createLinearOctree builds over the stream's vertices.
+LinearOctree* createLinearOctree(const ObjVoxelStream& stream, int depth);
+
+// The octrees createLinearOctreeFromTriangles and
+// createSolidLinearOctreeFromTriangles build over the stream's triangles,
+// which must have been kept. Polygons are fanned rather than ear clipped as
+// LoadObj does; the two differ only for concave faces.
+LinearOctree* createLinearOctreeFromTriangles(const ObjVoxelStream& stream, int depth, bool conservative = false);
+LinearOctree* createSolidLinearOctree(const ObjVoxelStream& stream, int depth);
+
+template <typename Real>
+void AddObjStreamVertex(void* stream, Real x, Real y, Real z, Real)
+{
+	static_cast<ObjVoxelStream*>(stream)->AddVertex(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z));
+}
+
+template <typename Index>
+void AddObjStreamFace(void* stream, Index* corners, int count)
+{
+	for (int i = 2; i < count; ++i) {
+		static_cast<ObjVoxelStream*>(stream)->AddTriangle(corners[0].vertex_index, corners[i - 1].vertex_index, corners[i].vertex_index);
+	}
+}
+
+// Parses filename into stream. Callback is the caller's tinyobj::callback_t,
+// through which LoadObjWithCallback is found by argument-dependent lookup, so
+// each project streams with its own tinyobj (as AppendTriangleIndices takes
+// its shapes). False if the file cannot be opened.
+template <typename Callback>
+bool StreamObjFile(const char* filename, ObjVoxelStream& stream, std::string* err = nullptr)
+{
+	std::ifstream ifs(filename);
+	if (!ifs)
+		return false;
+
+	Callback callback;
+	callback.vertex_cb = AddObjStreamVertex;
+	if (stream.keepTriangles) {
+		callback.index_cb = AddObjStreamFace;
+	}
+
+	return LoadObjWithCallback(ifs, callback, &stream, nullptr, err);
+}
@@ -0,0 +1,358 @@
+#include "OutOfCoreVoxelizer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <ppl.h>
+
+#define NOMINMAX
+#include <windows.h>
+
+using namespace DirectX;
+
+static const size_t ReadBufferBytes = 1 << 20;
+
+// 4096 bricks at most, so a brick buffer is still a few KB at small budgets.
+static const int MaxBrickLevel = 4;
+
+// Calls vertex(p) for every "v x y z" line, reading the file ReadBufferBytes
+// at a time. False if the file cannot be opened.
+template <typename Function>
+static bool ForEachObjVertex(const char* filename, Function vertex)
+{
+	FILE* fp = nullptr;
+
+	fopen_s(&fp, filename, "rb");
+	if (!fp)
+		return false;
+
+	std::vector<char> buffer(ReadBufferBytes + 1);
+	size_t carried = 0;
+	bool atEnd = false;
+
+	while (!atEnd) {
+		// A line longer than the buffer grows it.
+		if (carried == buffer.size() - 1) {
+			buffer.resize(2 * buffer.size());
+		}
+
+		const size_t read = fread(buffer.data() + carried, 1, buffer.size() - 1 - carried, fp);
+		const size_t size = carried + read;
+		atEnd = read == 0;
+
+		// Whole lines only, unless the file ends without a newline.
+		size_t end = size;
+		if (!atEnd) {
+			while (end > 0 && buffer[end - 1] != '\n') {
+				--end;
+			}
+		}
+		// Terminated so strtod stops at the end of the chunk; the first
+		// character of the carried line is put back after.
+		const char carriedFirst = buffer[end];
+		buffer[end] = '\0';
+
+		for (char* line = buffer.data(); line < buffer.data() + end; ) {
+			char* next = static_cast<char*>(memchr(line, '\n', buffer.data() + end - line));
+			next = next ? next + 1 : buffer.data() + end;
+
+			while (*line == ' ' || *line == '\t') {
+				++line;
+			}
+
+			if (line[0] == 'v' && (line[1] == ' ' || line[1] == '\t')) {
+				char* p = line + 2;
+				XMFLOAT3 v;
+				v.x = static_cast<float>(strtod(p, &p));
+				v.y = static_cast<float>(strtod(p, &p));
+				v.z = static_cast<float>(strtod(p, &p));
+				vertex(v);
+			}
+
+			line = next;
+		}
+
+		buffer[end] = carriedFirst;
+		carried = size - end;
+		memmove(buffer.data(), buffer.data() + end, carried);
+	}
+
+	fclose(fp);
+	return true;
+}
+
+// The spill files of one run, named after the process and a per-process
+// counter so concurrent runs sharing a directory never meet. A brick's file
+// is created, truncating anything left by a crashed run, on its first spill,
+// and every file created is removed when the run ends, however it ends.
+class BrickFiles {
+public:
+	BrickFiles(const std::string& directory, size_t brickCount)
+		: created(brickCount, false)
+	{
+		static std::atomic<unsigned> runs(0);
+
+		prefix = (directory.empty() ? std::string() : directory + "\\")
+			+ "voxelizer_" + std::to_string(GetCurrentProcessId()) + "_" + std::to_string(runs++) + "_brick";
+	}
+
+	~BrickFiles()
+	{
+		for (size_t brick = 0; brick < created.size(); ++brick) {
+			if (created[brick]) {
+				remove(Filename(brick).c_str());
+			}
+		}
+	}
+
+	BrickFiles(const BrickFiles&) = delete;
+	BrickFiles& operator=(const BrickFiles&) = delete;
+
+	// Sorts and deduplicates codes, then appends them to the brick's file.
+	bool Spill(size_t brick, std::vector<uint64_t>& codes, size_t& spilledBytes)
+	{
+		std::sort(codes.begin(), codes.end());
+		codes.erase(std::unique(codes.begin(), codes.end()), codes.end());
+
+		FILE* fp = nullptr;
+		fopen_s(&fp, Filename(brick).c_str(), created[brick] ? "ab" : "wb");
+		if (!fp)
+			return false;
+
+		created[brick] = true;
+
+		const bool written = fwrite(codes.data(), sizeof(uint64_t), codes.size(), fp) == codes.size();
+		spilledBytes += codes.size() * sizeof(uint64_t);
+		codes.clear();
+
+		return fclose(fp) == 0 && written;
+	}
+
+	bool Read(size_t brick, std::vector<uint64_t>& codes) const
+	{
+		if (!created[brick])
+			return true; // never spilled, so empty
+
+		FILE* fp = nullptr;
+		fopen_s(&fp, Filename(brick).c_str(), "rb");
+		if (!fp)
+			return false;
+
+		const long long bytes = FileBytes(fp);
+		if (bytes < 0) {
+			fclose(fp);
+			return false;
+		}
+
+		codes.resize(static_cast<size_t>(bytes) / sizeof(uint64_t));
+		const bool read = fread(codes.data(), sizeof(uint64_t), codes.size(), fp) == codes.size();
+
+		fclose(fp);
+		return read;
+	}
+
+	// Size of the brick's file, 0 if never spilled, -1 if it cannot be read.
+	long long Bytes(size_t brick) const
+	{
+		if (!created[brick])
+			return 0;
+
+		FILE* fp = nullptr;
+		fopen_s(&fp, Filename(brick).c_str(), "rb");
+		if (!fp)
+			return -1;
+
+		const long long bytes = FileBytes(fp);
+		fclose(fp);
+
+		return bytes;
+	}
+
+private:
+	std::string prefix;
+	std::vector<bool> created;
+
+	std::string Filename(size_t brick) const
+	{
+		return prefix + std::to_string(brick) + ".bin";
+	}
+
+	// 64-bit, as bricks can pass 2 GB; leaves fp at the start.
+	static long long FileBytes(FILE* fp)
+	{
+		if (_fseeki64(fp, 0, SEEK_END) != 0)
+			return -1;
+
+		const long long bytes = _ftelli64(fp);
+		_fseeki64(fp, 0, SEEK_SET);
+
+		return bytes;
+	}
+};
+
+// Bytes BuildLinearOctreeLevels needs for these sorted, unique leaf codes: the
+// codes of every level, with room for their vectors' growth above the
+// leaves, and the nodes.
+static unsigned long long OctreeBuildBytes(const std::vector<uint64_t>& leafCodes, int depth)
+{
+	unsigned long long nodes = leafCodes.size();
+	std::vector<uint64_t> last(depth, ~0ull);
+
+	for (uint64_t code : leafCodes) {
+		for (int level = depth - 1; level >= 0; --level) {
+			const uint64_t parent = code >> (3 * (depth - level));
+			if (parent == last[level])
+				break;
+
+			last[level] = parent;
+			++nodes;
+		}
+	}
+
+	return (leafCodes.size() + 2 * (nodes - leafCodes.size())) * sizeof(uint64_t) + nodes * sizeof(LinearOctreeNode);
+}
+
+LinearOctree* createLinearOctreeOutOfCore(const char* filename, int depth, size_t memoryBudget, const std::string& tempDirectory, std::string& err, OutOfCoreStats* stats)
+{
+	assert(depth > 0 && depth <= LinearOctree::MaxDepth);
+
+	OutOfCoreStats counts;
+	BoundingBox3D box;
+
+	if (!ForEachObjVertex(filename, [&](const XMFLOAT3& v) { box.AddPoint(v); ++counts.vertexCount; })) {
+		err = std::string(filename) + ": cannot open\n";
+		return nullptr;
+	}
+
+	LinearOctree* octree = new LinearOctree();
+	octree->boundingBox = box;
+	octree->depth = depth;
+
+	// Enough bricks that an average brick of raw codes is a quarter of the
+	// budget, leaving room for skew and for bricks sorted side by side.
+	const size_t budgetCodes = std::max<size_t>(memoryBudget / sizeof(uint64_t), 1024);
+	int brickLevel = 0;
+	while (brickLevel < std::min(depth, MaxBrickLevel) && (counts.vertexCount >> (3 * brickLevel)) > budgetCodes / 4) {
+		++brickLevel;
+	}
+	counts.brickLevel = brickLevel;
+
+	std::vector<uint64_t> leafCodes;
+	bool fits = true;
+
+	if (brickLevel == 0) {
+		// Fits: no spilling.
+		leafCodes.reserve(counts.vertexCount);
+		ForEachObjVertex(filename, [&](const XMFLOAT3& v) { leafCodes.push_back(octree->PointCode(v)); });
+
+		std::sort(leafCodes.begin(), leafCodes.end());
+		leafCodes.erase(std::unique(leafCodes.begin(), leafCodes.end()), leafCodes.end());
+	}
+	else {
+		const size_t brickCount = size_t(1) << (3 * brickLevel);
+		const int brickShift = 3 * (depth - brickLevel);
+		BrickFiles files(tempDirectory, brickCount);
+
+		// Half the budget buffers codes, split evenly between the bricks.
+		const size_t bufferCodes = std::max<size_t>(budgetCodes / 2 / brickCount, 64);
+		std::vector<std::vector<uint64_t>> buffers(brickCount);
+		bool spilled = true;
+
+		ForEachObjVertex(filename, [&](const XMFLOAT3& v) {
+			if (!spilled)
+				return;
+
+			const uint64_t code = octree->PointCode(v);
+			const size_t brick = static_cast<size_t>(code >> brickShift);
+			std::vector<uint64_t>& buffer = buffers[brick];
+
+			if (buffer.empty()) {
+				buffer.reserve(bufferCodes);
+			}
+			buffer.push_back(code);
+
+			if (buffer.size() == bufferCodes) {
+				spilled = files.Spill(brick, buffer, counts.spilledBytes);
+			}
+		});
+
+		for (size_t brick = 0; brick < brickCount && spilled; ++brick) {
+			if (!buffers[brick].empty()) {
+				spilled = files.Spill(brick, buffers[brick], counts.spilledBytes);
+			}
+		}
+		buffers = std::vector<std::vector<uint64_t>>();
+
+		// Waves of consecutive bricks that fit in the budget together with the
+		// leaf codes kept so far.
+		bool read = spilled;
+		for (size_t first = 0; first < brickCount && read && fits; ) {
+			const long long available = static_cast<long long>(memoryBudget) - static_cast<long long>(leafCodes.capacity() * sizeof(uint64_t));
+			size_t last = first;
+			long long waveBytes = 0;
+			while (last < brickCount) {
+				const long long bytes = files.Bytes(last);
+				if (bytes < 0) {
+					read = false;
+					break;
+				}
+				if (waveBytes + bytes > available)
+					break;
+				waveBytes += bytes;
+				++last;
+			}
+
+			if (!read)
+				break;
+
+			if (last == first) {
+				fits = false;
+				break;
+			}
+
+			std::vector<std::vector<uint64_t>> bricks(last - first);
+			std::atomic<bool> failed(false);
+
+			concurrency::parallel_for(first, last, [&](size_t brick) {
+				std::vector<uint64_t>& codes = bricks[brick - first];
+				if (!files.Read(brick, codes)) {
+					failed = true;
+				}
+				std::sort(codes.begin(), codes.end());
+				codes.erase(std::unique(codes.begin(), codes.end()), codes.end());
+			});
+
+			for (auto& codes : bricks) {
+				leafCodes.insert(leafCodes.end(), codes.begin(), codes.end());
+			}
+
+			read = !failed;
+			first = last;
+		}
+
+		if (!read) {
+			err = std::string(filename) + ": cannot " + (spilled ? "read" : "write") + " temporary files in " + (tempDirectory.empty() ? "." : tempDirectory) + "\n";
+			delete octree;
+			return nullptr;
+		}
+	}
+
+	if (!fits || OctreeBuildBytes(leafCodes, depth) > memoryBudget) {
+		err = std::string(filename) + ": the depth " + std::to_string(depth) + " octree does not fit in " + std::to_string(memoryBudget >> 20)
+			+ " MB; lower the depth or raise the budget\n";
+		delete octree;
+		return nullptr;
+	}
+
+	BuildLinearOctreeLevels(octree, leafCodes);
+
+	if (stats) {
+		*stats = counts;
+	}
+
+	return octree;
+}
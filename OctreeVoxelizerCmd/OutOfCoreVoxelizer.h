@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "LinearOctree.h"
+
+// Point voxelization of OBJ files too large to load. The file is read twice
+// in fixed-size chunks: once for the bounding box, once to bin the leaf code
+// of every vertex into the brick (a cell at a coarse level of the grid) it
+// falls in. Full brick buffers are spilled to temporary files. Each brick is
+// then sorted and deduplicated on its own, as many at a time in parallel as
+// fit in the budget. Bricks are contiguous runs of Morton codes, so the
+// bricks taken in order are the sorted leaf codes of the whole octree.
+//
+// The budget bounds the build, approximately: the brick buffers while the
+// file is binned, then the leaf codes kept so far plus the bricks being
+// sorted, then the octree's levels and nodes. An input whose octree does not
+// fit fails rather than going over. What the caller then builds from the
+// octree, such as meshes to write, is outside the budget.
+
+struct OutOfCoreStats {
+	size_t vertexCount = 0;
+	int brickLevel = 0;    // bricks are the 8^brickLevel cells of this level
+	size_t spilledBytes = 0;
+};
+
+// Same octree as createLinearOctree over the file's vertices. Temporary files
+// go to tempDirectory, or the working directory if it is empty, and are
+// removed before returning. Returns nullptr with err set if the file cannot
+// be read, a temporary file cannot be written or the octree does not fit.
+LinearOctree* createLinearOctreeOutOfCore(const char* filename, int depth, size_t memoryBudget, const std::string& tempDirectory, std::string& err, OutOfCoreStats* stats = nullptr);
@@ -0,0 +1,961 @@
+#include "ParallelObjLoader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <ppl.h>
+
+#define NOMINMAX
+#include <windows.h>
+
+using tinyobj::index_t;
+using tinyobj::real_t;
+
+// Below this many bytes per chunk, splitting costs more than it saves.
+static const size_t MinBytesPerChunk = 1 << 20;
+
+// A relative index is stored as (its element among the chunk's own) minus
+// RelativeIndexBias until the elements of the chunks before are counted.
+// Absent indices are -1 and absolute ones final, as tinyobj has them.
+static const int RelativeIndexBias = 1 << 30;
+
+// Read-only view of a whole file. An empty file opens with no view.
+class MappedObjFile {
+public:
+	MappedObjFile() : file(INVALID_HANDLE_VALUE), mapping(nullptr), view(nullptr), size(0) {}
+	~MappedObjFile();
+
+	bool Open(const char* filename);
+
+	const char* Data() const { return static_cast<const char*>(view); }
+	size_t Size() const { return size; }
+
+private:
+	HANDLE file;
+	HANDLE mapping;
+	const void* view;
+	size_t size;
+};
+
+bool MappedObjFile::Open(const char* filename)
+{
+	// Named in the ANSI code page, as for std::ifstream.
+	const int length = MultiByteToWideChar(CP_ACP, 0, filename, -1, nullptr, 0);
+	if (length <= 0)
+		return false;
+
+	std::vector<wchar_t> wideFilename(length);
+	MultiByteToWideChar(CP_ACP, 0, filename, -1, wideFilename.data(), length);
+
+	file = CreateFile2(wideFilename.data(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+		return false;
+
+	size = static_cast<size_t>(fileSize.QuadPart);
+	if (size == 0)
+		return true;
+
+	mapping = CreateFileMappingFromApp(file, nullptr, PAGE_READONLY, 0, nullptr);
+	if (mapping == nullptr)
+		return false;
+
+	view = MapViewOfFileFromApp(mapping, FILE_MAP_READ, 0, 0);
+	return view != nullptr;
+}
+
+MappedObjFile::~MappedObjFile()
+{
+	if (view != nullptr) {
+		UnmapViewOfFile(view);
+	}
+	if (mapping != nullptr) {
+		CloseHandle(mapping);
+	}
+	if (file != INVALID_HANDLE_VALUE) {
+		CloseHandle(file);
+	}
+}
+
+// Lines other than v/vn/vt/f, kept to be replayed in file order.
+enum class ObjStatementType {
+	UseMaterial,
+	MaterialLibrary,
+	Group,
+	Object,
+	Tag,
+	Smoothing
+};
+
+struct ObjStatement {
+	ObjStatementType type;
+	size_t face;       // faces of the chunk before the statement
+	size_t corner;     // and their corners
+	const char* begin; // from the keyword
+	const char* end;   // to the line end
+};
+
+struct ObjChunk {
+	const char* begin;
+	const char* end;
+
+	std::vector<real_t> v, vn, vt, vc;
+	std::vector<index_t> corners;
+	std::vector<uint32_t> faceSizes;
+	std::vector<ObjStatement> statements;
+
+	bool failed;
+
+	ObjChunk() : begin(nullptr), end(nullptr), failed(false) {}
+};
+
+// Parsing mirrors tinyobj over [p, end) instead of a null-terminated line;
+// a line never holds '\r' or '\n', which end it.
+
+static inline bool IsObjSpace(char c)
+{
+	return c == ' ' || c == '\t';
+}
+
+static inline bool IsObjDigit(char c)
+{
+	return static_cast<unsigned int>(c - '0') < 10u;
+}
+
+static inline const char* SkipSpaces(const char* p, const char* end)
+{
+	while (p < end && IsObjSpace(*p)) {
+		++p;
+	}
+	return p;
+}
+
+static inline const char* SkipToSpace(const char* p, const char* end)
+{
+	while (p < end && !IsObjSpace(*p)) {
+		++p;
+	}
+	return p;
+}
+
+// atoi, stopping at end.
+static inline int ParseObjInt(const char* p, const char* end)
+{
+	while (p < end && (IsObjSpace(*p) || *p == '\v' || *p == '\f')) {
+		++p;
+	}
+
+	bool negative = false;
+	if (p < end && (*p == '+' || *p == '-')) {
+		negative = *p == '-';
+		++p;
+	}
+
+	unsigned int value = 0;
+	while (p < end && IsObjDigit(*p)) {
+		value = 10 * value + static_cast<unsigned int>(*p - '0');
+		++p;
+	}
+
+	return static_cast<int>(negative ? 0u - value : value);
+}
+
+// tinyobj's tryParseDouble: the same grammar, and the same operations on the
+// digits, so the values are bit-identical. Fails without setting result.
+static bool ParseObjDouble(const char* s, const char* end, double* result)
+{
+	static const double FractionScales[] = {
+		1.0, 0.1, 0.01, 0.001, 0.0001, 0.00001, 0.000001, 0.0000001,
+	};
+	const int fractionScaleCount = sizeof FractionScales / sizeof FractionScales[0];
+
+	if (s >= end)
+		return false;
+
+	const char* p = s;
+	bool negative = false;
+
+	if (*p == '+' || *p == '-') {
+		negative = *p == '-';
+		++p;
+	}
+	else if (!IsObjDigit(*p))
+		return false;
+
+	double mantissa = 0.0;
+	int exponent = 0;
+
+	const char* integer = p;
+	while (p < end && IsObjDigit(*p)) {
+		mantissa *= 10;
+		mantissa += static_cast<int>(*p - 0x30);
+		++p;
+	}
+
+	if (p == integer)
+		return false;
+
+	if (p < end && *p == '.') {
+		++p;
+		for (int read = 1; p < end && IsObjDigit(*p); ++read, ++p) {
+			mantissa += static_cast<int>(*p - 0x30) *
+				(read < fractionScaleCount ? FractionScales[read] : std::pow(10.0, -read));
+		}
+	}
+
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		++p;
+
+		bool negativeExponent = false;
+		if (p < end && (*p == '+' || *p == '-')) {
+			negativeExponent = *p == '-';
+			++p;
+		}
+		else if (p == end || !IsObjDigit(*p))
+			return false;
+
+		const char* digits = p;
+		while (p < end && IsObjDigit(*p)) {
+			exponent *= 10;
+			exponent += static_cast<int>(*p - 0x30);
+			++p;
+		}
+
+		if (p == digits)
+			return false;
+
+		exponent *= negativeExponent ? -1 : 1;
+	}
+
+	*result = (negative ? -1 : 1) *
+		(exponent ? std::ldexp(mantissa * std::pow(5.0, exponent), exponent) : mantissa);
+	return true;
+}
+
+// tinyobj's parseReal: the next space-delimited token, defaultValue if it
+// does not start with a number.
+static inline real_t ParseObjReal(const char*& p, const char* end, double defaultValue = 0.0)
+{
+	p = SkipSpaces(p, end);
+	const char* tokenEnd = SkipToSpace(p, end);
+
+	double value = defaultValue;
+	ParseObjDouble(p, tokenEnd, &value);
+
+	p = tokenEnd;
+	return static_cast<real_t>(value);
+}
+
+static inline std::string ParseObjString(const char*& p, const char* end)
+{
+	p = SkipSpaces(p, end);
+	const char* tokenEnd = SkipToSpace(p, end);
+
+	std::string s(p, tokenEnd);
+
+	p = tokenEnd;
+	return s;
+}
+
+// tinyobj's fixIndex, with relative indices left for the merge.
+static inline bool FixObjIndex(int index, size_t localCount, int* fixed)
+{
+	if (index > 0) {
+		*fixed = index - 1;
+		return true;
+	}
+
+	if (index == 0)
+		return false;
+
+	*fixed = static_cast<int>(localCount) + index - RelativeIndexBias;
+	return true;
+}
+
+static inline const char* SkipObjIndex(const char* p, const char* end)
+{
+	while (p < end && *p != '/' && !IsObjSpace(*p)) {
+		++p;
+	}
+	return p;
+}
+
+// tinyobj's parseTriple: i, i/j, i//k or i/j/k. False on a zero index, which
+// is also what anything not starting with a number reads as.
+static bool ParseObjCorner(const char*& p, const char* end, const ObjChunk& chunk, index_t* corner)
+{
+	corner->vertex_index = -1;
+	corner->normal_index = -1;
+	corner->texcoord_index = -1;
+
+	if (!FixObjIndex(ParseObjInt(p, end), chunk.v.size() / 3, &corner->vertex_index))
+		return false;
+
+	p = SkipObjIndex(p, end);
+	if (p == end || *p != '/')
+		return true;
+	++p;
+
+	// i//k
+	if (p < end && *p == '/') {
+		++p;
+		if (!FixObjIndex(ParseObjInt(p, end), chunk.vn.size() / 3, &corner->normal_index))
+			return false;
+		p = SkipObjIndex(p, end);
+		return true;
+	}
+
+	// i/j or i/j/k
+	if (!FixObjIndex(ParseObjInt(p, end), chunk.vt.size() / 2, &corner->texcoord_index))
+		return false;
+
+	p = SkipObjIndex(p, end);
+	if (p == end || *p != '/')
+		return true;
+	++p;
+
+	if (!FixObjIndex(ParseObjInt(p, end), chunk.vn.size() / 3, &corner->normal_index))
+		return false;
+	p = SkipObjIndex(p, end);
+
+	return true;
+}
+
+static inline bool IsObjKeyword(const char* p, const char* end, const char* keyword, size_t length)
+{
+	return static_cast<size_t>(end - p) > length && memcmp(p, keyword, length) == 0 && IsObjSpace(p[length]);
+}
+
+static void AddObjStatement(ObjChunk& chunk, ObjStatementType type, const char* begin, const char* end)
+{
+	const ObjStatement statement = { type, chunk.faceSizes.size(), chunk.corners.size(), begin, end };
+	chunk.statements.push_back(statement);
+}
+
+// False if the line is a face tinyobj fails on.
+static bool ParseObjLine(ObjChunk& chunk, const char* p, const char* end)
+{
+	p = SkipSpaces(p, end);
+
+	if (p == end || p[0] == '#')
+		return true;
+
+	if (IsObjKeyword(p, end, "v", 1)) {
+		p += 2;
+		chunk.v.push_back(ParseObjReal(p, end));
+		chunk.v.push_back(ParseObjReal(p, end));
+		chunk.v.push_back(ParseObjReal(p, end));
+
+		chunk.vc.push_back(ParseObjReal(p, end, 1.0));
+		chunk.vc.push_back(ParseObjReal(p, end, 1.0));
+		chunk.vc.push_back(ParseObjReal(p, end, 1.0));
+		return true;
+	}
+
+	if (IsObjKeyword(p, end, "vn", 2)) {
+		p += 3;
+		chunk.vn.push_back(ParseObjReal(p, end));
+		chunk.vn.push_back(ParseObjReal(p, end));
+		chunk.vn.push_back(ParseObjReal(p, end));
+		return true;
+	}
+
+	if (IsObjKeyword(p, end, "vt", 2)) {
+		p += 3;
+		chunk.vt.push_back(ParseObjReal(p, end));
+		chunk.vt.push_back(ParseObjReal(p, end));
+		return true;
+	}
+
+	if (IsObjKeyword(p, end, "f", 1)) {
+		p = SkipSpaces(p + 2, end);
+
+		uint32_t size = 0;
+		while (p < end) {
+			index_t corner;
+			if (!ParseObjCorner(p, end, chunk, &corner))
+				return false;
+
+			chunk.corners.push_back(corner);
+			++size;
+			p = SkipSpaces(p, end);
+		}
+
+		chunk.faceSizes.push_back(size);
+		return true;
+	}
+
+	if (IsObjKeyword(p, end, "usemtl", 6)) {
+		AddObjStatement(chunk, ObjStatementType::UseMaterial, p, end);
+	}
+	else if (IsObjKeyword(p, end, "mtllib", 6)) {
+		AddObjStatement(chunk, ObjStatementType::MaterialLibrary, p, end);
+	}
+	else if (IsObjKeyword(p, end, "g", 1)) {
+		AddObjStatement(chunk, ObjStatementType::Group, p, end);
+	}
+	else if (IsObjKeyword(p, end, "o", 1)) {
+		AddObjStatement(chunk, ObjStatementType::Object, p, end);
+	}
+	else if (IsObjKeyword(p, end, "t", 1)) {
+		AddObjStatement(chunk, ObjStatementType::Tag, p, end);
+	}
+	else if (IsObjKeyword(p, end, "s", 1)) {
+		AddObjStatement(chunk, ObjStatementType::Smoothing, p, end);
+	}
+
+	return true;
+}
+
+// Lines end at '\n' or '\r', so "\r\n" leaves an empty line, which is skipped.
+static void ParseObjChunk(ObjChunk& chunk)
+{
+	for (const char* line = chunk.begin; line < chunk.end; ) {
+		const char* lineEnd = line;
+		while (lineEnd < chunk.end && *lineEnd != '\n' && *lineEnd != '\r') {
+			++lineEnd;
+		}
+
+		if (!ParseObjLine(chunk, line, lineEnd)) {
+			chunk.failed = true;
+			return;
+		}
+
+		line = lineEnd + 1;
+	}
+}
+
+static inline void FixRelativeIndex(int& index, size_t offset)
+{
+	if (index < -1) {
+		index += RelativeIndexBias + static_cast<int>(offset);
+	}
+}
+
+// Consecutive faces of one chunk with one smoothing group.
+struct ObjFaceRun {
+	const ObjChunk* chunk;
+	size_t faceBegin, faceEnd;
+	size_t cornerBegin;
+	unsigned int smoothingGroup;
+};
+
+static void AddObjFaceRun(std::vector<ObjFaceRun>& faceGroup, const ObjChunk& chunk, size_t faceBegin, size_t faceEnd, size_t cornerBegin, unsigned int smoothingGroup)
+{
+	if (faceEnd > faceBegin) {
+		const ObjFaceRun run = { &chunk, faceBegin, faceEnd, cornerBegin, smoothingGroup };
+		faceGroup.push_back(run);
+	}
+}
+
+static inline void AddObjTriangle(tinyobj::mesh_t& mesh, const index_t& a, const index_t& b, const index_t& c, int material, unsigned int smoothingGroup)
+{
+	mesh.indices.push_back(a);
+	mesh.indices.push_back(b);
+	mesh.indices.push_back(c);
+
+	mesh.num_face_vertices.push_back(3);
+	mesh.material_ids.push_back(material);
+	mesh.smoothing_group_ids.push_back(smoothingGroup);
+}
+
+// tinyobj's pnpoly.
+static int PointInTriangle(const real_t* vx, const real_t* vy, real_t x, real_t y)
+{
+	int c = 0;
+	for (int i = 0, j = 2; i < 3; j = i++) {
+		if (((vy[i] > y) != (vy[j] > y)) &&
+			(x < (vx[j] - vx[i]) * (y - vy[i]) / (vy[j] - vy[i]) + vx[i]))
+			c = !c;
+	}
+	return c;
+}
+
+// The ear clipping of tinyobj's exportFaceGroupToShape, for a face of more
+// than three corners.
+static void TriangulateObjPolygon(tinyobj::mesh_t& mesh, const index_t* corners, size_t count, int material, unsigned int smoothingGroup, const std::vector<real_t>& v)
+{
+	// The two axes to work in.
+	size_t axes[2] = { 1, 2 };
+	for (size_t k = 0; k < count; ++k) {
+		const size_t vi0 = size_t(corners[k].vertex_index);
+		const size_t vi1 = size_t(corners[(k + 1) % count].vertex_index);
+		const size_t vi2 = size_t(corners[(k + 2) % count].vertex_index);
+		const real_t e0x = v[vi1 * 3 + 0] - v[vi0 * 3 + 0];
+		const real_t e0y = v[vi1 * 3 + 1] - v[vi0 * 3 + 1];
+		const real_t e0z = v[vi1 * 3 + 2] - v[vi0 * 3 + 2];
+		const real_t e1x = v[vi2 * 3 + 0] - v[vi1 * 3 + 0];
+		const real_t e1y = v[vi2 * 3 + 1] - v[vi1 * 3 + 1];
+		const real_t e1z = v[vi2 * 3 + 2] - v[vi1 * 3 + 2];
+		const real_t cx = std::fabs(e0y * e1z - e0z * e1y);
+		const real_t cy = std::fabs(e0z * e1x - e0x * e1z);
+		const real_t cz = std::fabs(e0x * e1y - e0y * e1x);
+		const real_t epsilon = std::numeric_limits<real_t>::epsilon();
+		if (cx > epsilon || cy > epsilon || cz > epsilon) {
+			// A corner.
+			if (!(cx > cy && cx > cz)) {
+				axes[0] = 0;
+				if (cz > cx && cz > cy) {
+					axes[1] = 1;
+				}
+			}
+			break;
+		}
+	}
+
+	real_t area = 0;
+	for (size_t k = 0; k < count; ++k) {
+		const size_t vi0 = size_t(corners[k].vertex_index);
+		const size_t vi1 = size_t(corners[(k + 1) % count].vertex_index);
+		const real_t v0x = v[vi0 * 3 + axes[0]];
+		const real_t v0y = v[vi0 * 3 + axes[1]];
+		const real_t v1x = v[vi1 * 3 + axes[0]];
+		const real_t v1y = v[vi1 * 3 + axes[1]];
+		area += (v0x * v1y - v0y * v1x) * static_cast<real_t>(0.5);
+	}
+
+	// Bounds the passes over the remaining corners, as tinyobj does.
+	int maxRounds = 10;
+
+	std::vector<index_t> remaining(corners, corners + count);
+	size_t guess = 0;
+	index_t ind[3];
+	real_t vx[3];
+	real_t vy[3];
+
+	while (remaining.size() > 3 && maxRounds > 0) {
+		const size_t n = remaining.size();
+		if (guess >= n) {
+			maxRounds -= 1;
+			guess -= n;
+		}
+
+		for (size_t k = 0; k < 3; ++k) {
+			ind[k] = remaining[(guess + k) % n];
+			const size_t vi = size_t(ind[k].vertex_index);
+			vx[k] = v[vi * 3 + axes[0]];
+			vy[k] = v[vi * 3 + axes[1]];
+		}
+
+		const real_t e0x = vx[1] - vx[0];
+		const real_t e0y = vy[1] - vy[0];
+		const real_t e1x = vx[2] - vx[1];
+		const real_t e1y = vy[2] - vy[1];
+		const real_t cross = e0x * e1y - e0y * e1x;
+
+		// A reflex corner.
+		if (cross * area < static_cast<real_t>(0.0)) {
+			guess += 1;
+			continue;
+		}
+
+		bool overlap = false;
+		for (size_t other = 3; other < n; ++other) {
+			const size_t vi = size_t(remaining[(guess + other) % n].vertex_index);
+			if (PointInTriangle(vx, vy, v[vi * 3 + axes[0]], v[vi * 3 + axes[1]])) {
+				overlap = true;
+				break;
+			}
+		}
+
+		if (overlap) {
+			guess += 1;
+			continue;
+		}
+
+		// An ear: cut it off.
+		AddObjTriangle(mesh, ind[0], ind[1], ind[2], material, smoothingGroup);
+		remaining.erase(remaining.begin() + (guess + 1) % n);
+	}
+
+	if (remaining.size() == 3) {
+		AddObjTriangle(mesh, remaining[0], remaining[1], remaining[2], material, smoothingGroup);
+	}
+}
+
+// tinyobj's exportFaceGroupToShape.
+static bool ExportObjFaceGroup(tinyobj::shape_t& shape, const std::vector<ObjFaceRun>& faceGroup, const std::vector<tinyobj::tag_t>& tags, int material, const std::string& name, bool triangulate, const std::vector<real_t>& v)
+{
+	if (faceGroup.empty())
+		return false;
+
+	tinyobj::mesh_t& mesh = shape.mesh;
+
+	for (const ObjFaceRun& run : faceGroup) {
+		const index_t* corners = run.chunk->corners.data() + run.cornerBegin;
+
+		for (size_t f = run.faceBegin; f < run.faceEnd; ++f) {
+			const size_t count = run.chunk->faceSizes[f];
+			const index_t* face = corners;
+			corners += count;
+
+			// A face has three corners or more.
+			if (count < 3)
+				continue;
+
+			if (!triangulate) {
+				mesh.indices.insert(mesh.indices.end(), face, face + count);
+				mesh.num_face_vertices.push_back(static_cast<unsigned char>(count));
+				mesh.material_ids.push_back(material);
+				mesh.smoothing_group_ids.push_back(run.smoothingGroup);
+			}
+			else if (count == 3) {
+				AddObjTriangle(mesh, face[0], face[1], face[2], material, run.smoothingGroup);
+			}
+			else {
+				TriangulateObjPolygon(mesh, face, count, material, run.smoothingGroup, v);
+			}
+		}
+	}
+
+	shape.name = name;
+	shape.mesh.tags = tags;
+
+	return true;
+}
+
+// Shapes, materials, smoothing groups and tags, built from the statements
+// and the faces between them in file order, as tinyobj builds them.
+class ObjReplay {
+public:
+	ObjReplay(std::vector<tinyobj::shape_t>* shapes, std::vector<tinyobj::material_t>* materials, std::string* err, tinyobj::MaterialReader* readMaterial, bool triangulate, const std::vector<real_t>& v)
+		: shapes(shapes), materials(materials), err(err), readMaterial(readMaterial), triangulate(triangulate), v(v), material(-1), smoothingGroup(0) {}
+
+	void Chunk(const ObjChunk& chunk);
+	void Finish();
+
+private:
+	std::vector<tinyobj::shape_t>* shapes;
+	std::vector<tinyobj::material_t>* materials;
+	std::string* err;
+	tinyobj::MaterialReader* readMaterial;
+	bool triangulate;
+	const std::vector<real_t>& v;
+
+	std::map<std::string, int> materialMap;
+	int material;
+	unsigned int smoothingGroup;
+	std::vector<tinyobj::tag_t> tags;
+	std::string name;
+	tinyobj::shape_t shape;
+	std::vector<ObjFaceRun> faceGroup;
+
+	bool ExportFaceGroup() { return ExportObjFaceGroup(shape, faceGroup, tags, material, name, triangulate, v); }
+
+	void UseMaterial(const char* p, const char* end);
+	void MaterialLibrary(const char* p, const char* end);
+	void Group(const char* p, const char* end);
+	void Object(const char* p, const char* end);
+	void Tag(const char* p, const char* end);
+	void Smoothing(const char* p, const char* end);
+};
+
+void ObjReplay::Chunk(const ObjChunk& chunk)
+{
+	size_t face = 0;
+	size_t corner = 0;
+
+	for (const ObjStatement& statement : chunk.statements) {
+		AddObjFaceRun(faceGroup, chunk, face, statement.face, corner, smoothingGroup);
+		face = statement.face;
+		corner = statement.corner;
+
+		switch (statement.type) {
+		case ObjStatementType::UseMaterial:
+			UseMaterial(statement.begin, statement.end);
+			break;
+		case ObjStatementType::MaterialLibrary:
+			MaterialLibrary(statement.begin, statement.end);
+			break;
+		case ObjStatementType::Group:
+			Group(statement.begin, statement.end);
+			break;
+		case ObjStatementType::Object:
+			Object(statement.begin, statement.end);
+			break;
+		case ObjStatementType::Tag:
+			Tag(statement.begin, statement.end);
+			break;
+		case ObjStatementType::Smoothing:
+			Smoothing(statement.begin, statement.end);
+			break;
+		}
+	}
+
+	AddObjFaceRun(faceGroup, chunk, face, chunk.faceSizes.size(), corner, smoothingGroup);
+}
+
+void ObjReplay::Finish()
+{
+	// A usemtl on the last line exports the faces before it, leaving the
+	// group empty but the shape not.
+	if (ExportFaceGroup() || shape.mesh.indices.size()) {
+		shapes->push_back(shape);
+	}
+	faceGroup.clear();
+}
+
+void ObjReplay::UseMaterial(const char* p, const char* end)
+{
+	const std::string materialName(p + 7, end);
+
+	int newMaterial = -1;
+	const auto found = materialMap.find(materialName);
+	if (found != materialMap.end()) {
+		newMaterial = found->second;
+	}
+
+	// Faces of the material so far go to the shape, which stays open.
+	if (newMaterial != material) {
+		ExportFaceGroup();
+		faceGroup.clear();
+		material = newMaterial;
+	}
+}
+
+void ObjReplay::MaterialLibrary(const char* p, const char* end)
+{
+	if (!readMaterial)
+		return;
+
+	// Split at every single space, as tinyobj's SplitString.
+	std::vector<std::string> filenames;
+	std::stringstream ss(std::string(p + 7, end));
+	std::string item;
+	while (std::getline(ss, item, ' ')) {
+		filenames.push_back(item);
+	}
+
+	if (filenames.empty()) {
+		if (err) {
+			(*err) += "WARN: Looks like empty filename for mtllib. Use default material. \n";
+		}
+		return;
+	}
+
+	for (const std::string& filename : filenames) {
+		std::string materialErr;
+		const bool ok = (*readMaterial)(filename.c_str(), materials, &materialMap, &materialErr);
+		if (err && !materialErr.empty()) {
+			(*err) += materialErr;
+		}
+
+		if (ok)
+			return;
+	}
+
+	if (err) {
+		(*err) += "WARN: Failed to load material file(s). Use default material.\n";
+	}
+}
+
+void ObjReplay::Group(const char* p, const char* end)
+{
+	ExportFaceGroup();
+
+	if (shape.mesh.indices.size() > 0) {
+		shapes->push_back(shape);
+	}
+
+	shape = tinyobj::shape_t();
+	faceGroup.clear();
+
+	// The first name after g; the material carries over.
+	p = SkipSpaces(p + 1, end);
+	name = std::string(p, SkipToSpace(p, end));
+}
+
+void ObjReplay::Object(const char* p, const char* end)
+{
+	if (ExportFaceGroup()) {
+		shapes->push_back(shape);
+	}
+
+	faceGroup.clear();
+	shape = tinyobj::shape_t();
+
+	// The rest of the line, spaces and all.
+	name = std::string(p + 2, end);
+}
+
+// Counts of the tag's ints, reals and strings: n, n/n or n/n/n.
+static void ParseObjTagSizes(const char*& p, const char* end, int counts[3])
+{
+	counts[0] = counts[1] = counts[2] = 0;
+
+	for (int i = 0; i < 2; ++i) {
+		p = SkipSpaces(p, end);
+		counts[i] = ParseObjInt(p, end);
+		p = SkipObjIndex(p, end);
+
+		if (p == end || *p != '/')
+			return;
+		++p;
+	}
+
+	// The last count runs to the next space, slashes and all.
+	p = SkipSpaces(p, end);
+	counts[2] = ParseObjInt(p, end);
+	p = SkipToSpace(p, end);
+}
+
+void ObjReplay::Tag(const char* p, const char* end)
+{
+	tinyobj::tag_t tag;
+
+	p += 2;
+	tag.name = ParseObjString(p, end);
+
+	int counts[3];
+	ParseObjTagSizes(p, end, counts);
+
+	tag.intValues.resize(static_cast<size_t>(counts[0]));
+	for (size_t i = 0; i < tag.intValues.size(); ++i) {
+		p = SkipSpaces(p, end);
+		tag.intValues[i] = ParseObjInt(p, end);
+		p = SkipToSpace(p, end);
+	}
+
+	tag.floatValues.resize(static_cast<size_t>(counts[1]));
+	for (size_t i = 0; i < tag.floatValues.size(); ++i) {
+		tag.floatValues[i] = ParseObjReal(p, end);
+	}
+
+	tag.stringValues.resize(static_cast<size_t>(counts[2]));
+	for (size_t i = 0; i < tag.stringValues.size(); ++i) {
+		tag.stringValues[i] = ParseObjString(p, end);
+	}
+
+	tags.push_back(tag);
+}
+
+void ObjReplay::Smoothing(const char* p, const char* end)
+{
+	p = SkipSpaces(p + 2, end);
+
+	if (p == end)
+		return;
+
+	// tinyobj reads "off", or a number of at most two characters; longer
+	// numbers leave the group as it was.
+	if (end - p >= 3) {
+		if (p[0] == 'o' && p[1] == 'f' && p[2] == 'f') {
+			smoothingGroup = 0;
+		}
+	}
+	else {
+		const int group = ParseObjInt(p, end);
+		smoothingGroup = group < 0 ? 0 : static_cast<unsigned int>(group);
+	}
+}
+
+bool LoadObjParallel(tinyobj::attrib_t* attrib, std::vector<tinyobj::shape_t>* shapes, std::vector<tinyobj::material_t>* materials, std::string* err, const char* filename, const char* mtl_basedir, bool triangulate)
+{
+	attrib->vertices.clear();
+	attrib->normals.clear();
+	attrib->texcoords.clear();
+	attrib->colors.clear();
+	shapes->clear();
+
+	MappedObjFile file;
+	if (!file.Open(filename)) {
+		if (err) {
+			std::stringstream errss;
+			errss << "Cannot open file [" << filename << "]" << std::endl;
+			(*err) = errss.str();
+		}
+		return false;
+	}
+
+	const char* data = file.Data();
+	const size_t size = file.Size();
+
+	// Cuts are moved forward to the next line start.
+	const size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	const size_t chunkCount = std::max<size_t>(std::min(threads, size / MinBytesPerChunk), 1);
+
+	std::vector<ObjChunk> chunks(chunkCount);
+	chunks[0].begin = data;
+	chunks[chunkCount - 1].end = data + size;
+
+	for (size_t c = 1; c < chunkCount; ++c) {
+		const char* cut = std::max(data + size / chunkCount * c, chunks[c - 1].begin);
+		while (cut < data + size && *cut != '\n' && *cut != '\r') {
+			++cut;
+		}
+		if (cut < data + size) {
+			++cut;
+		}
+
+		chunks[c - 1].end = cut;
+		chunks[c].begin = cut;
+	}
+
+	concurrency::parallel_for(size_t(0), chunkCount, [&](size_t c) {
+		ParseObjChunk(chunks[c]);
+	});
+
+	for (const ObjChunk& chunk : chunks) {
+		if (chunk.failed) {
+			if (err) {
+				(*err) = "Failed parse `f' line(e.g. zero value for face index).\n";
+			}
+			return false;
+		}
+	}
+
+	// Offsets of each chunk's elements in the whole file.
+	std::vector<size_t> vOffsets(chunkCount + 1, 0), vnOffsets(chunkCount + 1, 0), vtOffsets(chunkCount + 1, 0);
+	for (size_t c = 0; c < chunkCount; ++c) {
+		vOffsets[c + 1] = vOffsets[c] + chunks[c].v.size();
+		vnOffsets[c + 1] = vnOffsets[c] + chunks[c].vn.size();
+		vtOffsets[c + 1] = vtOffsets[c] + chunks[c].vt.size();
+	}
+
+	attrib->vertices.resize(vOffsets[chunkCount]);
+	attrib->colors.resize(vOffsets[chunkCount]);
+	attrib->normals.resize(vnOffsets[chunkCount]);
+	attrib->texcoords.resize(vtOffsets[chunkCount]);
+
+	concurrency::parallel_for(size_t(0), chunkCount, [&](size_t c) {
+		ObjChunk& chunk = chunks[c];
+
+		std::copy(chunk.v.begin(), chunk.v.end(), attrib->vertices.begin() + vOffsets[c]);
+		std::copy(chunk.vc.begin(), chunk.vc.end(), attrib->colors.begin() + vOffsets[c]);
+		std::copy(chunk.vn.begin(), chunk.vn.end(), attrib->normals.begin() + vnOffsets[c]);
+		std::copy(chunk.vt.begin(), chunk.vt.end(), attrib->texcoords.begin() + vtOffsets[c]);
+
+		chunk.v = std::vector<real_t>();
+		chunk.vc = std::vector<real_t>();
+		chunk.vn = std::vector<real_t>();
+		chunk.vt = std::vector<real_t>();
+
+		for (index_t& corner : chunk.corners) {
+			FixRelativeIndex(corner.vertex_index, vOffsets[c] / 3);
+			FixRelativeIndex(corner.normal_index, vnOffsets[c] / 3);
+			FixRelativeIndex(corner.texcoord_index, vtOffsets[c] / 2);
+		}
+	});
+
+	std::string baseDir;
+	if (mtl_basedir) {
+		baseDir = mtl_basedir;
+	}
+	tinyobj::MaterialFileReader materialReader(baseDir);
+
+	ObjReplay replay(shapes, materials, err, &materialReader, triangulate, attrib->vertices);
+	for (const ObjChunk& chunk : chunks) {
+		replay.Chunk(chunk);
+	}
+	replay.Finish();
+
+	return true;
+}
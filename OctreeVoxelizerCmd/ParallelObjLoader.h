@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "tiny_obj_loader.h"
+
+// Multithreaded drop-in for tinyobj::LoadObj on a file. The file is mapped
+// and cut at line ends into one chunk per thread. Each chunk is parsed on its
+// own into v/vn/vt/color arrays and face corners, with relative (negative)
+// indices kept relative to the chunk. The arrays are then concatenated and
+// the indices offset by the counts of the chunks before.
+//
+// Shapes, materials, smoothing groups and tags come from replaying the
+// statements other than v/vn/vt/f in file order, so attrib and shapes are the
+// same as LoadObj's: numbers are converted with tinyobj's own digit arithmetic
+// (bit-identical values), and polygons are triangulated by the same ear
+// clipping. Unlike LoadObj, a malformed face fails the load without reading
+// the material files named before it.
+bool LoadObjParallel(tinyobj::attrib_t* attrib, std::vector<tinyobj::shape_t>* shapes, std::vector<tinyobj::material_t>* materials, std::string* err, const char* filename, const char* mtl_basedir = nullptr, bool triangulate = true);
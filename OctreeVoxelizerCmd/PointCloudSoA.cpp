@@ -0,0 +1,472 @@
+#include "PointCloudSoA.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstring>
+
+#if defined(_M_IX86) || defined(_M_X64)
+#define POINTCLOUD_X86
+#include <intrin.h>
+#include <immintrin.h>
+#elif defined(_M_ARM64)
+#define POINTCLOUD_NEON
+#include <arm64_neon.h>
+#elif defined(_M_ARM)
+#define POINTCLOUD_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace DirectX;
+
+void PointCloudSoA::Assign(const std::vector<XMFLOAT3*>& vertices)
+{
+	x.resize(vertices.size());
+	y.resize(vertices.size());
+	z.resize(vertices.size());
+
+	for (size_t i = 0; i < vertices.size(); ++i) {
+		x[i] = vertices[i]->x;
+		y[i] = vertices[i]->y;
+		z[i] = vertices[i]->z;
+	}
+}
+
+void PointCloudSoA::Assign(const std::vector<float>& positions)
+{
+	const size_t count = positions.size() / 3;
+
+	x.resize(count);
+	y.resize(count);
+	z.resize(count);
+
+	for (size_t i = 0; i < count; ++i) {
+		x[i] = positions[3 * i + 0];
+		y[i] = positions[3 * i + 1];
+		z[i] = positions[3 * i + 2];
+	}
+}
+
+// Runtime dispatch
+
+static SimdLevel detectSimdLevel()
+{
+#if defined(POINTCLOUD_X86)
+	int info[4];
+
+	__cpuid(info, 0);
+	const int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+
+	// AVX2 needs the CPU feature and the OS saving the ymm registers.
+	if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6) {
+		__cpuidex(info, 7, 0);
+		if ((info[1] & (1 << 5)) != 0)
+			return SimdLevel::AVX2;
+	}
+
+	return SimdLevel::SSE2; // baseline on every x86 target we build
+#elif defined(POINTCLOUD_NEON)
+	return SimdLevel::NEON;
+#else
+	return SimdLevel::Scalar;
+#endif
+}
+
+static const SimdLevel supportedSimdLevel = detectSimdLevel();
+// Set by SetSimdLevel while builders on other threads may be running kernels.
+static std::atomic<SimdLevel> currentSimdLevel(supportedSimdLevel);
+
+SimdLevel GetSupportedSimdLevel()
+{
+	return supportedSimdLevel;
+}
+
+SimdLevel GetSimdLevel()
+{
+	return currentSimdLevel.load();
+}
+
+void SetSimdLevel(SimdLevel level)
+{
+	if (level == SimdLevel::Scalar || level == supportedSimdLevel
+		|| (level == SimdLevel::SSE2 && supportedSimdLevel == SimdLevel::AVX2)) {
+		currentSimdLevel = level;
+	}
+	else {
+		currentSimdLevel = supportedSimdLevel;
+	}
+}
+
+const char* SimdLevelName(SimdLevel level)
+{
+	switch (level) {
+	case SimdLevel::SSE2: return "SSE2";
+	case SimdLevel::AVX2: return "AVX2";
+	case SimdLevel::NEON: return "NEON";
+	default: return "Scalar";
+	}
+}
+
+// Scalar kernels, also used for the tails of the vector loops
+
+static inline void addPoints(BoundingBox3D& box, const float* px, const float* py, const float* pz, size_t n)
+{
+	for (size_t i = 0; i < n; ++i) {
+		box.AddPoint(XMFLOAT3(px[i], py[i], pz[i]));
+	}
+}
+
+// Folds per-lane minima and maxima of the vector loops into box.
+static inline void mergeLanes(BoundingBox3D& box, const float (*lanes)[8], int count)
+{
+	for (int k = 0; k < count; ++k) {
+		box.Min.x = lanes[0][k] < box.Min.x ? lanes[0][k] : box.Min.x;
+		box.Min.y = lanes[1][k] < box.Min.y ? lanes[1][k] : box.Min.y;
+		box.Min.z = lanes[2][k] < box.Min.z ? lanes[2][k] : box.Min.z;
+
+		box.Max.x = lanes[3][k] > box.Max.x ? lanes[3][k] : box.Max.x;
+		box.Max.y = lanes[4][k] > box.Max.y ? lanes[4][k] : box.Max.y;
+		box.Max.z = lanes[5][k] > box.Max.z ? lanes[5][k] : box.Max.z;
+	}
+}
+
+static inline uint8_t classifyOctant(float x, float y, float z, const BoundingBox3D& box, const XMFLOAT3& mid)
+{
+	if (!box.IncludePoint(XMFLOAT3(x, y, z)))
+		return 8;
+
+	return static_cast<uint8_t>((x > mid.x ? 1 : 0) | (y > mid.y ? 2 : 0) | (z > mid.z ? 4 : 0));
+}
+
+static inline size_t countAbove(const float* values, size_t n, float split)
+{
+	size_t count = 0;
+
+	for (size_t i = 0; i < n; ++i) {
+		count += values[i] > split ? 1 : 0;
+	}
+
+	return count;
+}
+
+#if defined(POINTCLOUD_X86)
+
+// SSE2 kernels
+
+static void computeBoundingBoxSSE2(BoundingBox3D& box, const float* px, const float* py, const float* pz, size_t n)
+{
+	__m128 minX = _mm_set1_ps(FLT_MAX), minY = minX, minZ = minX;
+	__m128 maxX = _mm_set1_ps(-FLT_MAX), maxY = maxX, maxZ = maxX;
+
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const __m128 x = _mm_loadu_ps(px + i);
+		const __m128 y = _mm_loadu_ps(py + i);
+		const __m128 z = _mm_loadu_ps(pz + i);
+
+		minX = _mm_min_ps(minX, x); maxX = _mm_max_ps(maxX, x);
+		minY = _mm_min_ps(minY, y); maxY = _mm_max_ps(maxY, y);
+		minZ = _mm_min_ps(minZ, z); maxZ = _mm_max_ps(maxZ, z);
+	}
+
+	float lanes[6][8];
+	_mm_storeu_ps(lanes[0], minX); _mm_storeu_ps(lanes[1], minY); _mm_storeu_ps(lanes[2], minZ);
+	_mm_storeu_ps(lanes[3], maxX); _mm_storeu_ps(lanes[4], maxY); _mm_storeu_ps(lanes[5], maxZ);
+
+	mergeLanes(box, lanes, 4);
+
+	addPoints(box, px + i, py + i, pz + i, n - i);
+}
+
+static void classifyOctantsSSE2(const float* px, const float* py, const float* pz, size_t n, const BoundingBox3D& box, const XMFLOAT3& mid, uint8_t* octants)
+{
+	const __m128 midX = _mm_set1_ps(mid.x), midY = _mm_set1_ps(mid.y), midZ = _mm_set1_ps(mid.z);
+	const __m128 minX = _mm_set1_ps(box.Min.x), minY = _mm_set1_ps(box.Min.y), minZ = _mm_set1_ps(box.Min.z);
+	const __m128 maxX = _mm_set1_ps(box.Max.x), maxY = _mm_set1_ps(box.Max.y), maxZ = _mm_set1_ps(box.Max.z);
+	const __m128i bitX = _mm_set1_epi32(1), bitY = _mm_set1_epi32(2), bitZ = _mm_set1_epi32(4);
+	const __m128i outside = _mm_set1_epi32(8);
+
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const __m128 x = _mm_loadu_ps(px + i);
+		const __m128 y = _mm_loadu_ps(py + i);
+		const __m128 z = _mm_loadu_ps(pz + i);
+
+		__m128i octant = _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(x, midX)), bitX);
+		octant = _mm_or_si128(octant, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(y, midY)), bitY));
+		octant = _mm_or_si128(octant, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(z, midZ)), bitZ));
+
+		__m128 inside = _mm_and_ps(_mm_cmpgt_ps(x, minX), _mm_cmplt_ps(x, maxX));
+		inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpgt_ps(y, minY), _mm_cmplt_ps(y, maxY)));
+		inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpgt_ps(z, minZ), _mm_cmplt_ps(z, maxZ)));
+
+		const __m128i mask = _mm_castps_si128(inside);
+		octant = _mm_or_si128(_mm_and_si128(mask, octant), _mm_andnot_si128(mask, outside));
+
+		const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(octant, octant), _mm_setzero_si128());
+		const int packed = _mm_cvtsi128_si32(bytes);
+		memcpy(octants + i, &packed, 4);
+	}
+
+	for (; i < n; ++i) {
+		octants[i] = classifyOctant(px[i], py[i], pz[i], box, mid);
+	}
+}
+
+static size_t countAboveSSE2(const float* values, size_t n, float split)
+{
+	const __m128 s = _mm_set1_ps(split);
+	__m128i counts = _mm_setzero_si128();
+
+	// A true compare is all ones, i.e. -1 per lane.
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		counts = _mm_sub_epi32(counts, _mm_castps_si128(_mm_cmpgt_ps(_mm_loadu_ps(values + i), s)));
+	}
+
+	uint32_t lanes[4];
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), counts);
+
+	return size_t(lanes[0]) + lanes[1] + lanes[2] + lanes[3] + countAbove(values + i, n - i, split);
+}
+
+// AVX2 kernels. Only called after detectSimdLevel found AVX2.
+
+static void computeBoundingBoxAVX2(BoundingBox3D& box, const float* px, const float* py, const float* pz, size_t n)
+{
+	__m256 minX = _mm256_set1_ps(FLT_MAX), minY = minX, minZ = minX;
+	__m256 maxX = _mm256_set1_ps(-FLT_MAX), maxY = maxX, maxZ = maxX;
+
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m256 x = _mm256_loadu_ps(px + i);
+		const __m256 y = _mm256_loadu_ps(py + i);
+		const __m256 z = _mm256_loadu_ps(pz + i);
+
+		minX = _mm256_min_ps(minX, x); maxX = _mm256_max_ps(maxX, x);
+		minY = _mm256_min_ps(minY, y); maxY = _mm256_max_ps(maxY, y);
+		minZ = _mm256_min_ps(minZ, z); maxZ = _mm256_max_ps(maxZ, z);
+	}
+
+	float lanes[6][8];
+	_mm256_storeu_ps(lanes[0], minX); _mm256_storeu_ps(lanes[1], minY); _mm256_storeu_ps(lanes[2], minZ);
+	_mm256_storeu_ps(lanes[3], maxX); _mm256_storeu_ps(lanes[4], maxY); _mm256_storeu_ps(lanes[5], maxZ);
+	_mm256_zeroupper();
+
+	mergeLanes(box, lanes, 8);
+
+	addPoints(box, px + i, py + i, pz + i, n - i);
+}
+
+static void classifyOctantsAVX2(const float* px, const float* py, const float* pz, size_t n, const BoundingBox3D& box, const XMFLOAT3& mid, uint8_t* octants)
+{
+	const __m256 midX = _mm256_set1_ps(mid.x), midY = _mm256_set1_ps(mid.y), midZ = _mm256_set1_ps(mid.z);
+	const __m256 minX = _mm256_set1_ps(box.Min.x), minY = _mm256_set1_ps(box.Min.y), minZ = _mm256_set1_ps(box.Min.z);
+	const __m256 maxX = _mm256_set1_ps(box.Max.x), maxY = _mm256_set1_ps(box.Max.y), maxZ = _mm256_set1_ps(box.Max.z);
+	const __m256i bitX = _mm256_set1_epi32(1), bitY = _mm256_set1_epi32(2), bitZ = _mm256_set1_epi32(4);
+	const __m256i outside = _mm256_set1_epi32(8);
+
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m256 x = _mm256_loadu_ps(px + i);
+		const __m256 y = _mm256_loadu_ps(py + i);
+		const __m256 z = _mm256_loadu_ps(pz + i);
+
+		__m256i octant = _mm256_and_si256(_mm256_castps_si256(_mm256_cmp_ps(x, midX, _CMP_GT_OQ)), bitX);
+		octant = _mm256_or_si256(octant, _mm256_and_si256(_mm256_castps_si256(_mm256_cmp_ps(y, midY, _CMP_GT_OQ)), bitY));
+		octant = _mm256_or_si256(octant, _mm256_and_si256(_mm256_castps_si256(_mm256_cmp_ps(z, midZ, _CMP_GT_OQ)), bitZ));
+
+		__m256 inside = _mm256_and_ps(_mm256_cmp_ps(x, minX, _CMP_GT_OQ), _mm256_cmp_ps(x, maxX, _CMP_LT_OQ));
+		inside = _mm256_and_ps(inside, _mm256_and_ps(_mm256_cmp_ps(y, minY, _CMP_GT_OQ), _mm256_cmp_ps(y, maxY, _CMP_LT_OQ)));
+		inside = _mm256_and_ps(inside, _mm256_and_ps(_mm256_cmp_ps(z, minZ, _CMP_GT_OQ), _mm256_cmp_ps(z, maxZ, _CMP_LT_OQ)));
+
+		octant = _mm256_blendv_epi8(outside, octant, _mm256_castps_si256(inside));
+
+		const __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(octant), _mm256_extracti128_si256(octant, 1));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(octants + i), _mm_packus_epi16(words, words));
+	}
+	_mm256_zeroupper();
+
+	for (; i < n; ++i) {
+		octants[i] = classifyOctant(px[i], py[i], pz[i], box, mid);
+	}
+}
+
+static size_t countAboveAVX2(const float* values, size_t n, float split)
+{
+	const __m256 s = _mm256_set1_ps(split);
+	__m256i counts = _mm256_setzero_si256();
+
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		counts = _mm256_sub_epi32(counts, _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(values + i), s, _CMP_GT_OQ)));
+	}
+
+	uint32_t lanes[8];
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), counts);
+	_mm256_zeroupper();
+
+	size_t count = 0;
+	for (int k = 0; k < 8; ++k) {
+		count += lanes[k];
+	}
+
+	return count + countAbove(values + i, n - i, split);
+}
+
+#elif defined(POINTCLOUD_NEON)
+
+// NEON kernels
+
+static void computeBoundingBoxNEON(BoundingBox3D& box, const float* px, const float* py, const float* pz, size_t n)
+{
+	float32x4_t minX = vdupq_n_f32(FLT_MAX), minY = minX, minZ = minX;
+	float32x4_t maxX = vdupq_n_f32(-FLT_MAX), maxY = maxX, maxZ = maxX;
+
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const float32x4_t x = vld1q_f32(px + i);
+		const float32x4_t y = vld1q_f32(py + i);
+		const float32x4_t z = vld1q_f32(pz + i);
+
+		minX = vminq_f32(minX, x); maxX = vmaxq_f32(maxX, x);
+		minY = vminq_f32(minY, y); maxY = vmaxq_f32(maxY, y);
+		minZ = vminq_f32(minZ, z); maxZ = vmaxq_f32(maxZ, z);
+	}
+
+	float lanes[6][8];
+	vst1q_f32(lanes[0], minX); vst1q_f32(lanes[1], minY); vst1q_f32(lanes[2], minZ);
+	vst1q_f32(lanes[3], maxX); vst1q_f32(lanes[4], maxY); vst1q_f32(lanes[5], maxZ);
+
+	mergeLanes(box, lanes, 4);
+
+	addPoints(box, px + i, py + i, pz + i, n - i);
+}
+
+static void classifyOctantsNEON(const float* px, const float* py, const float* pz, size_t n, const BoundingBox3D& box, const XMFLOAT3& mid, uint8_t* octants)
+{
+	const float32x4_t midX = vdupq_n_f32(mid.x), midY = vdupq_n_f32(mid.y), midZ = vdupq_n_f32(mid.z);
+	const float32x4_t minX = vdupq_n_f32(box.Min.x), minY = vdupq_n_f32(box.Min.y), minZ = vdupq_n_f32(box.Min.z);
+	const float32x4_t maxX = vdupq_n_f32(box.Max.x), maxY = vdupq_n_f32(box.Max.y), maxZ = vdupq_n_f32(box.Max.z);
+	const uint32x4_t bitX = vdupq_n_u32(1), bitY = vdupq_n_u32(2), bitZ = vdupq_n_u32(4);
+	const uint32x4_t outside = vdupq_n_u32(8);
+
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const float32x4_t x = vld1q_f32(px + i);
+		const float32x4_t y = vld1q_f32(py + i);
+		const float32x4_t z = vld1q_f32(pz + i);
+
+		uint32x4_t octant = vandq_u32(vcgtq_f32(x, midX), bitX);
+		octant = vorrq_u32(octant, vandq_u32(vcgtq_f32(y, midY), bitY));
+		octant = vorrq_u32(octant, vandq_u32(vcgtq_f32(z, midZ), bitZ));
+
+		uint32x4_t inside = vandq_u32(vcgtq_f32(x, minX), vcltq_f32(x, maxX));
+		inside = vandq_u32(inside, vandq_u32(vcgtq_f32(y, minY), vcltq_f32(y, maxY)));
+		inside = vandq_u32(inside, vandq_u32(vcgtq_f32(z, minZ), vcltq_f32(z, maxZ)));
+
+		octant = vbslq_u32(inside, octant, outside);
+
+		const uint16x4_t words = vmovn_u32(octant);
+		uint8_t bytes[8];
+		vst1_u8(bytes, vmovn_u16(vcombine_u16(words, words)));
+		memcpy(octants + i, bytes, 4);
+	}
+
+	for (; i < n; ++i) {
+		octants[i] = classifyOctant(px[i], py[i], pz[i], box, mid);
+	}
+}
+
+static size_t countAboveNEON(const float* values, size_t n, float split)
+{
+	const float32x4_t s = vdupq_n_f32(split);
+	uint32x4_t counts = vdupq_n_u32(0);
+
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		counts = vsubq_u32(counts, vcgtq_f32(vld1q_f32(values + i), s));
+	}
+
+	return size_t(vgetq_lane_u32(counts, 0)) + vgetq_lane_u32(counts, 1) + vgetq_lane_u32(counts, 2) + vgetq_lane_u32(counts, 3)
+		+ countAbove(values + i, n - i, split);
+}
+
+#endif
+
+// Dispatching entry points
+
+BoundingBox3D ComputeBoundingBox(const PointCloudSoA& points, size_t begin, size_t end)
+{
+	assert(begin <= end && end <= points.size());
+
+	const float* px = points.x.data() + begin;
+	const float* py = points.y.data() + begin;
+	const float* pz = points.z.data() + begin;
+	const size_t n = end - begin;
+
+	BoundingBox3D box;
+
+	switch (currentSimdLevel.load()) {
+#if defined(POINTCLOUD_X86)
+	case SimdLevel::AVX2: computeBoundingBoxAVX2(box, px, py, pz, n); break;
+	case SimdLevel::SSE2: computeBoundingBoxSSE2(box, px, py, pz, n); break;
+#elif defined(POINTCLOUD_NEON)
+	case SimdLevel::NEON: computeBoundingBoxNEON(box, px, py, pz, n); break;
+#endif
+	default: addPoints(box, px, py, pz, n); break;
+	}
+
+	return box;
+}
+
+void ClassifyOctants(const PointCloudSoA& points, size_t begin, size_t end, const BoundingBox3D& box, uint8_t* octants)
+{
+	assert(begin <= end && end <= points.size());
+
+	const float* px = points.x.data() + begin;
+	const float* py = points.y.data() + begin;
+	const float* pz = points.z.data() + begin;
+	const size_t n = end - begin;
+
+	const XMFLOAT3 mid(
+		(box.Min.x + box.Max.x) * 0.5f,
+		(box.Min.y + box.Max.y) * 0.5f,
+		(box.Min.z + box.Max.z) * 0.5f);
+
+	switch (currentSimdLevel.load()) {
+#if defined(POINTCLOUD_X86)
+	case SimdLevel::AVX2: classifyOctantsAVX2(px, py, pz, n, box, mid, octants); break;
+	case SimdLevel::SSE2: classifyOctantsSSE2(px, py, pz, n, box, mid, octants); break;
+#elif defined(POINTCLOUD_NEON)
+	case SimdLevel::NEON: classifyOctantsNEON(px, py, pz, n, box, mid, octants); break;
+#endif
+	default:
+		for (size_t i = 0; i < n; ++i) {
+			octants[i] = classifyOctant(px[i], py[i], pz[i], box, mid);
+		}
+		break;
+	}
+}
+
+size_t CountAbove(const PointCloudSoA& points, size_t begin, size_t end, int axis, float split)
+{
+	assert(begin <= end && end <= points.size());
+	assert(axis >= 0 && axis < 3);
+
+	const float* values = points.Axis(axis) + begin;
+	const size_t n = end - begin;
+
+	switch (currentSimdLevel.load()) {
+#if defined(POINTCLOUD_X86)
+	case SimdLevel::AVX2: return countAboveAVX2(values, n, split);
+	case SimdLevel::SSE2: return countAboveSSE2(values, n, split);
+#elif defined(POINTCLOUD_NEON)
+	case SimdLevel::NEON: return countAboveNEON(values, n, split);
+#endif
+	default: return countAbove(values, n, split);
+	}
+}
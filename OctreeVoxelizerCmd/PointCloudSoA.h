@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "BoundingBox3D.h"
+
+// Structure-of-arrays copy of a point set, so the per-point kernels below can
+// load four (SSE2, NEON) or eight (AVX2) coordinates of one axis at a time
+// instead of chasing one XMFLOAT3* per point. BinaryTree keeps one in the
+// order of its vertices for its box and split scans.
+
+struct PointCloudSoA {
+	std::vector<float> x, y, z;
+
+	size_t size() const { return x.size(); }
+	const float* Axis(int axis) const { return axis == 0 ? x.data() : axis == 1 ? y.data() : z.data(); }
+
+	void Assign(const std::vector<DirectX::XMFLOAT3*>& vertices);
+	void Assign(const std::vector<float>& positions); // xyz per vertex, as tinyobj attrib_t::vertices
+};
+
+enum class SimdLevel { Scalar, SSE2, AVX2, NEON };
+
+// Best level supported by the CPU, detected once.
+SimdLevel GetSupportedSimdLevel();
+
+// Level used by the kernels. Defaults to the supported level; a request above
+// it is clamped. Meant for benchmarking against the scalar path; safe to call
+// while kernels run on other threads, which see the old or the new level.
+SimdLevel GetSimdLevel();
+void SetSimdLevel(SimdLevel level);
+
+const char* SimdLevelName(SimdLevel level);
+
+// Bounding box of points [begin, end).
+BoundingBox3D ComputeBoundingBox(const PointCloudSoA& points, size_t begin, size_t end);
+
+// Writes the child octant of each point in [begin, end) to octants[i - begin]:
+// bit 0 is x > mid.x, bit 1 y > mid.y, bit 2 z > mid.z, as in Morton codes.
+// Points not strictly inside box (BoundingBox3D::IncludePoint) get 8.
+void ClassifyOctants(const PointCloudSoA& points, size_t begin, size_t end, const BoundingBox3D& box, uint8_t* octants);
+
+// Number of points in [begin, end) whose coordinate on axis is > split.
+size_t CountAbove(const PointCloudSoA& points, size_t begin, size_t end, int axis, float split);
@@ -0,0 +1,207 @@
+#include "PointDownsampler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <thread>
+#include <ppl.h>
+
+#include "VoxelHashTable.h"
+
+using namespace DirectX;
+
+static const int CellKeyBits = 21;
+static const int32_t CellKeyOffset = 1 << (CellKeyBits - 1);
+
+// Below this many points per chunk, splitting costs more than it saves.
+static const size_t MinPointsPerChunk = 65536;
+
+uint64_t VoxelCellKey(const XMFLOAT3& p, float inverseCellSize)
+{
+	const float* pPoint = &p.x;
+	uint64_t key = 0;
+
+	for (int axis = 0; axis < 3; ++axis) {
+		const float cell = std::floor(pPoint[axis] * inverseCellSize);
+		const float clamped = std::min(std::max(cell, static_cast<float>(-CellKeyOffset)), static_cast<float>(CellKeyOffset - 1));
+		key |= static_cast<uint64_t>(static_cast<int32_t>(clamped) + CellKeyOffset) << (CellKeyBits * axis);
+	}
+
+	return key;
+}
+
+static void CellCenter(uint64_t key, float cellSize, float* center)
+{
+	for (int axis = 0; axis < 3; ++axis) {
+		const int32_t cell = static_cast<int32_t>((key >> (CellKeyBits * axis)) & ((1u << CellKeyBits) - 1)) - CellKeyOffset;
+		center[axis] = (cell + 0.5f) * cellSize;
+	}
+}
+
+// Sums are doubles: a float sum of millions of points drifts.
+struct CellAccumulator {
+	double sum[3];
+	uint32_t count;
+	uint32_t closest;
+	float closestDistance;
+};
+
+// The cells of one chunk of points, in order of their first point there.
+struct PartialVoxelGrid {
+	VoxelHashTable table;
+	std::vector<uint64_t> keys;
+	std::vector<CellAccumulator> cells;
+	std::vector<double> attributeSums;
+};
+
+// Index of key's cell in grid, added empty if new.
+static uint32_t FindOrAddCell(PartialVoxelGrid& grid, uint64_t key, int attributeStride)
+{
+	bool inserted;
+	const uint32_t cell = grid.table.FindOrInsert(key, static_cast<uint32_t>(grid.cells.size()), inserted);
+
+	if (inserted) {
+		const CellAccumulator empty = { { 0, 0, 0 }, 0, 0, FLT_MAX };
+		grid.keys.push_back(key);
+		grid.cells.push_back(empty);
+		grid.attributeSums.resize(grid.attributeSums.size() + attributeStride, 0.0);
+	}
+
+	return cell;
+}
+
+template <typename Point>
+static void DownsampleRange(Point point, size_t begin, size_t end, float cellSize, VoxelRepresentative representative, const float* attributes, int attributeStride, PartialVoxelGrid& grid)
+{
+	const float inverseCellSize = 1.f / cellSize;
+	const bool closest = representative == VoxelRepresentative::ClosestToCenter;
+
+	for (size_t i = begin; i < end; ++i) {
+		const XMFLOAT3& p = point(i);
+		const uint64_t key = VoxelCellKey(p, inverseCellSize);
+		CellAccumulator& cell = grid.cells[FindOrAddCell(grid, key, attributeStride)];
+
+		cell.sum[0] += p.x;
+		cell.sum[1] += p.y;
+		cell.sum[2] += p.z;
+		++cell.count;
+
+		if (closest) {
+			float center[3];
+			CellCenter(key, cellSize, center);
+
+			const float dx = p.x - center[0], dy = p.y - center[1], dz = p.z - center[2];
+			const float distance = dx * dx + dy * dy + dz * dz;
+
+			// Ties keep the earlier point.
+			if (distance < cell.closestDistance) {
+				cell.closestDistance = distance;
+				cell.closest = static_cast<uint32_t>(i);
+			}
+		}
+
+		if (attributes) {
+			double* sums = &grid.attributeSums[(&cell - grid.cells.data()) * attributeStride];
+			const float* values = attributes + i * attributeStride;
+			for (int a = 0; a < attributeStride; ++a) {
+				sums[a] += values[a];
+			}
+		}
+	}
+}
+
+template <typename Point>
+static void downsamplePoints(Point point, size_t count, float cellSize, VoxelRepresentative representative, DownsampledPoints& result, const float* attributes, int attributeStride)
+{
+	assert(cellSize > 0);
+
+	if (!attributes) {
+		attributeStride = 0;
+	}
+
+	const size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	const size_t chunkCount = std::max<size_t>(std::min(threads, count / MinPointsPerChunk), 1);
+	const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+	std::vector<PartialVoxelGrid> partials(chunkCount);
+
+	concurrency::parallel_for(size_t(0), chunkCount, [&](size_t chunk) {
+		const size_t begin = chunk * chunkSize;
+		DownsampleRange(point, begin, std::min(begin + chunkSize, count), cellSize, representative, attributes, attributeStride, partials[chunk]);
+	});
+
+	// Merged in chunk order into the first partial, so cells keep the order
+	// of their first point and closest-point ties still keep the earlier one.
+	PartialVoxelGrid& merged = partials[0];
+
+	for (size_t chunk = 1; chunk < chunkCount; ++chunk) {
+		PartialVoxelGrid& partial = partials[chunk];
+
+		for (size_t j = 0; j < partial.cells.size(); ++j) {
+			const uint32_t index = FindOrAddCell(merged, partial.keys[j], attributeStride);
+			CellAccumulator& cell = merged.cells[index];
+			const CellAccumulator& other = partial.cells[j];
+
+			for (int axis = 0; axis < 3; ++axis) {
+				cell.sum[axis] += other.sum[axis];
+			}
+			cell.count += other.count;
+
+			if (other.closestDistance < cell.closestDistance) {
+				cell.closestDistance = other.closestDistance;
+				cell.closest = other.closest;
+			}
+
+			for (int a = 0; a < attributeStride; ++a) {
+				merged.attributeSums[index * attributeStride + a] += partial.attributeSums[j * attributeStride + a];
+			}
+		}
+
+		partial = PartialVoxelGrid();
+	}
+
+	const size_t cellCount = merged.cells.size();
+	const bool closest = representative == VoxelRepresentative::ClosestToCenter;
+
+	result.points.resize(cellCount);
+	result.counts.resize(cellCount);
+	result.sourceIndices.resize(closest ? cellCount : 0);
+	result.attributes.resize(cellCount * attributeStride);
+
+	for (size_t c = 0; c < cellCount; ++c) {
+		const CellAccumulator& cell = merged.cells[c];
+
+		if (closest) {
+			result.points[c] = point(cell.closest);
+			result.sourceIndices[c] = cell.closest;
+		}
+		else {
+			result.points[c] = XMFLOAT3(
+				static_cast<float>(cell.sum[0] / cell.count),
+				static_cast<float>(cell.sum[1] / cell.count),
+				static_cast<float>(cell.sum[2] / cell.count));
+		}
+		result.counts[c] = cell.count;
+
+		for (int a = 0; a < attributeStride; ++a) {
+			result.attributes[c * attributeStride + a] = static_cast<float>(merged.attributeSums[c * attributeStride + a] / cell.count);
+		}
+	}
+}
+
+void DownsamplePoints(const std::vector<float>& positions, float cellSize, VoxelRepresentative representative, DownsampledPoints& result, const float* attributes, int attributeStride)
+{
+	const XMFLOAT3* points = reinterpret_cast<const XMFLOAT3*>(positions.data());
+
+	downsamplePoints([points](size_t i) -> const XMFLOAT3& { return points[i]; },
+		positions.size() / 3, cellSize, representative, result, attributes, attributeStride);
+}
+
+void DownsamplePoints(const std::vector<XMFLOAT3*>& vertices, float cellSize, VoxelRepresentative representative, DownsampledPoints& result)
+{
+	const XMFLOAT3* const* points = vertices.data();
+
+	downsamplePoints([points](size_t i) -> const XMFLOAT3& { return *points[i]; },
+		vertices.size(), cellSize, representative, result, nullptr, 0);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <DirectXMath.h>
+
+// Voxel-grid filter for point clouds: one representative point per occupied
+// cube of a uniform grid anchored at the origin, in one pass over the points.
+// Chunks of points fill their own hash tables as tasks, which are merged in
+// chunk order, so the result does not depend on scheduling.
+
+// Cell of p, i.e. floor(p / cellSize) per axis, packed as 21 bits per axis.
+// Cells beyond +-2^20 along an axis are clamped to the last one.
+uint64_t VoxelCellKey(const DirectX::XMFLOAT3& p, float inverseCellSize);
+
+enum class VoxelRepresentative {
+	Centroid,       // mean of the cell's points
+	ClosestToCenter // the cell's input point nearest its center
+};
+
+struct DownsampledPoints {
+	std::vector<DirectX::XMFLOAT3> points; // one per cell, cells in order of their first point
+	std::vector<uint32_t> counts;          // input points per cell
+	std::vector<uint32_t> sourceIndices;   // ClosestToCenter: the input point chosen
+	std::vector<float> attributes;         // attributeStride means per cell, if attributes were given
+};
+
+// positions is xyz per point, as tinyobj attrib_t::vertices. attributes, if
+// not null, has attributeStride floats per point (e.g. attrib_t::colors, 3),
+// averaged over each cell whichever representative is chosen.
+void DownsamplePoints(const std::vector<float>& positions, float cellSize, VoxelRepresentative representative, DownsampledPoints& result, const float* attributes = nullptr, int attributeStride = 0);
+
+void DownsamplePoints(const std::vector<DirectX::XMFLOAT3*>& vertices, float cellSize, VoxelRepresentative representative, DownsampledPoints& result);
@@ -0,0 +1,291 @@
+#include "SparseVoxelDAG.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <unordered_map>
+
+const uint32_t SparseVoxelDAG::EmptyRoot;
+const uint32_t SparseVoxelDAG::FullRoot;
+
+static const uint32_t DAGMagic = 0x47445653; // "SVDG"
+static const uint32_t DAGVersion = 1;
+
+struct DAGFileHeader {
+	uint32_t magic;
+	uint32_t version;
+	int32_t depth;
+	uint32_t root;
+	float bounds[6]; // Min xyz, Max xyz
+	uint64_t wordCount;
+};
+
+static inline size_t nodeWordCount(uint32_t header)
+{
+	return 1 + ChildCount(DAGChildMask(header) & ~DAGCompleteMask(header));
+}
+
+static inline uint64_t hashWords(const uint32_t* words, size_t count)
+{
+	uint64_t hash = 14695981039346656037ull; // FNV-1a
+
+	for (size_t i = 0; i < count; ++i) {
+		hash = (hash ^ words[i]) * 1099511628211ull;
+	}
+
+	return hash;
+}
+
+SparseVoxelDAG* createSparseVoxelDAG(const LinearOctree* octree)
+{
+	SparseVoxelDAG* dag = new SparseVoxelDAG();
+	dag->boundingBox = octree->boundingBox;
+	dag->depth = octree->depth;
+
+	if (octree->nodes.empty())
+		return dag;
+
+	if (octree->nodes[0].isCompleteSubtree) {
+		dag->root = SparseVoxelDAG::FullRoot;
+		return dag;
+	}
+
+	// Word offset of every incomplete node, filled bottom-up so children are
+	// known before their parents. Complete nodes are never referenced.
+	std::vector<uint32_t> offsets(octree->nodes.size(), SparseVoxelDAG::EmptyRoot);
+	std::unordered_multimap<uint64_t, uint32_t> unique;
+	std::vector<uint32_t> encoding;
+
+	for (int level = octree->depth - 1; level >= 0; --level) {
+		for (uint32_t i = octree->levelOffsets[level]; i < octree->levelOffsets[level + 1]; ++i) {
+			const LinearOctreeNode& node = octree->nodes[i];
+
+			if (node.isCompleteSubtree)
+				continue;
+
+			uint32_t completeMask = 0;
+			encoding.assign(1, 0);
+
+			uint32_t child = node.firstChild;
+			for (int octant = 0; octant < 8; ++octant) {
+				if (!(node.childMask & (1 << octant)))
+					continue;
+
+				if (octree->nodes[child].isCompleteSubtree) {
+					completeMask |= 1 << octant;
+				}
+				else {
+					encoding.push_back(offsets[child]);
+				}
+				++child;
+			}
+
+			encoding[0] = node.childMask | completeMask << 8;
+
+			const uint64_t hash = hashWords(encoding.data(), encoding.size());
+			uint32_t offset = SparseVoxelDAG::EmptyRoot;
+
+			auto range = unique.equal_range(hash);
+			for (auto it = range.first; it != range.second; ++it) {
+				if (nodeWordCount(dag->words[it->second]) == encoding.size()
+					&& memcmp(&dag->words[it->second], encoding.data(), encoding.size() * sizeof(uint32_t)) == 0) {
+					offset = it->second;
+					break;
+				}
+			}
+
+			if (offset == SparseVoxelDAG::EmptyRoot) {
+				offset = static_cast<uint32_t>(dag->words.size());
+				dag->words.insert(dag->words.end(), encoding.begin(), encoding.end());
+				unique.emplace(hash, offset);
+			}
+
+			offsets[i] = offset;
+		}
+	}
+
+	dag->root = offsets[0];
+
+	return dag;
+}
+
+void BuildSparseVoxelDAGGeometry(const SparseVoxelDAG* dag, std::vector<BoundingBox3D>& boxGeometries)
+{
+	if (!dag || dag->root == SparseVoxelDAG::EmptyRoot)
+		return;
+
+	LinearOctree frame; // only for NodeBoundingBox
+	frame.boundingBox = dag->boundingBox;
+	frame.depth = dag->depth;
+
+	if (dag->root == SparseVoxelDAG::FullRoot) {
+		boxGeometries.push_back(dag->boundingBox);
+		return;
+	}
+
+	// Depth-first in octant order, as BuildLinearOctreeGeometry. Each entry is
+	// a node offset, or a complete cell marked by FullRoot.
+	struct Entry { uint32_t offset; uint64_t code; int level; };
+	std::vector<Entry> stack;
+	stack.push_back({ dag->root, 0, 0 });
+
+	while (!stack.empty()) {
+		const Entry entry = stack.back();
+		stack.pop_back();
+
+		if (entry.offset == SparseVoxelDAG::FullRoot) {
+			boxGeometries.push_back(frame.NodeBoundingBox(entry.code, entry.level));
+			continue;
+		}
+
+		const uint32_t* node = &dag->words[entry.offset];
+		const uint8_t childMask = DAGChildMask(node[0]);
+		const uint8_t completeMask = DAGCompleteMask(node[0]);
+
+		// Pointer slot of each octant, then push in reverse octant order.
+		uint32_t slots[8];
+		uint32_t slot = 1;
+		for (int octant = 0; octant < 8; ++octant) {
+			if ((childMask & ~completeMask) & (1 << octant))
+				slots[octant] = slot++;
+		}
+
+		for (int octant = 7; octant >= 0; --octant) {
+			if (!(childMask & (1 << octant)))
+				continue;
+
+			const uint64_t childCode = entry.code << 3 | octant;
+			const uint32_t childOffset = completeMask & (1 << octant) ? SparseVoxelDAG::FullRoot : node[slots[octant]];
+
+			stack.push_back({ childOffset, childCode, entry.level + 1 });
+		}
+	}
+}
+
+bool IsSparseVoxelDAGCellOccupied(const SparseVoxelDAG* dag, uint64_t code, int level)
+{
+	assert(level >= 0 && level <= dag->depth);
+
+	uint32_t offset = dag->root;
+
+	for (int l = 0; l < level; ++l) {
+		if (offset == SparseVoxelDAG::EmptyRoot)
+			return false;
+		if (offset == SparseVoxelDAG::FullRoot)
+			return true;
+
+		const uint32_t* node = &dag->words[offset];
+		const uint8_t childMask = DAGChildMask(node[0]);
+		const uint8_t completeMask = DAGCompleteMask(node[0]);
+		const int octant = static_cast<int>(code >> (3 * (level - l - 1))) & 7;
+
+		if (!(childMask & (1 << octant)))
+			return false;
+		if (completeMask & (1 << octant))
+			return true;
+
+		const uint8_t before = (childMask & ~completeMask) & ((1 << octant) - 1);
+		offset = node[1 + ChildCount(before)];
+	}
+
+	return offset != SparseVoxelDAG::EmptyRoot;
+}
+
+void SerializeSparseVoxelDAG(const SparseVoxelDAG* dag, std::vector<uint8_t>& bytes)
+{
+	DAGFileHeader header;
+	header.magic = DAGMagic;
+	header.version = DAGVersion;
+	header.depth = dag->depth;
+	header.root = dag->root;
+	header.bounds[0] = dag->boundingBox.Min.x;
+	header.bounds[1] = dag->boundingBox.Min.y;
+	header.bounds[2] = dag->boundingBox.Min.z;
+	header.bounds[3] = dag->boundingBox.Max.x;
+	header.bounds[4] = dag->boundingBox.Max.y;
+	header.bounds[5] = dag->boundingBox.Max.z;
+	header.wordCount = dag->words.size();
+
+	bytes.resize(sizeof(header) + dag->SizeInBytes());
+	memcpy(bytes.data(), &header, sizeof(header));
+	if (!dag->words.empty()) {
+		memcpy(bytes.data() + sizeof(header), dag->words.data(), dag->SizeInBytes());
+	}
+}
+
+// Walks the nodes in word order. Every node must fit in the words and point
+// only at nodes written before it, as createSparseVoxelDAG lays them out, so
+// traversals stay in bounds and end. The root's subtree must also be no
+// deeper than depth.
+static bool validateWords(const uint32_t* words, size_t wordCount, uint32_t root, int depth)
+{
+	const uint8_t NotANode = 0xff;
+	std::vector<uint8_t> heights(wordCount, NotANode); // levels below each node
+
+	for (size_t offset = 0; offset < wordCount; ) {
+		const uint32_t header = words[offset];
+		const uint8_t childMask = DAGChildMask(header);
+		const uint8_t completeMask = DAGCompleteMask(header);
+
+		if ((header >> 16) != 0 || childMask == 0 || (completeMask & ~childMask) != 0)
+			return false;
+
+		const size_t count = nodeWordCount(header);
+		if (count > wordCount - offset)
+			return false;
+
+		uint8_t height = 1;
+		for (size_t i = 1; i < count; ++i) {
+			const uint32_t child = words[offset + i];
+
+			if (child >= offset || heights[child] == NotANode)
+				return false;
+
+			height = std::max<uint8_t>(height, heights[child] + 1);
+		}
+
+		if (height > depth)
+			return false;
+
+		heights[offset] = height;
+		offset += count;
+	}
+
+	return root == SparseVoxelDAG::EmptyRoot || root == SparseVoxelDAG::FullRoot || heights[root] != NotANode;
+}
+
+bool DeserializeSparseVoxelDAG(const uint8_t* bytes, size_t size, SparseVoxelDAG* dag)
+{
+	DAGFileHeader header;
+
+	if (size < sizeof(header))
+		return false;
+
+	memcpy(&header, bytes, sizeof(header));
+
+	if (header.magic != DAGMagic || header.version != DAGVersion)
+		return false;
+	if (header.depth < 0 || header.depth > LinearOctree::MaxDepth)
+		return false;
+	if (header.wordCount > (size - sizeof(header)) / sizeof(uint32_t) || size != sizeof(header) + header.wordCount * sizeof(uint32_t))
+		return false;
+	if (header.root != SparseVoxelDAG::EmptyRoot && header.root != SparseVoxelDAG::FullRoot && header.root >= header.wordCount)
+		return false;
+
+	std::vector<uint32_t> words(static_cast<size_t>(header.wordCount));
+	if (!words.empty()) {
+		memcpy(words.data(), bytes + sizeof(header), words.size() * sizeof(uint32_t));
+	}
+
+	if (!validateWords(words.data(), words.size(), header.root, header.depth))
+		return false;
+
+	dag->depth = header.depth;
+	dag->root = header.root;
+	dag->boundingBox = BoundingBox3D(
+		DirectX::XMFLOAT3(header.bounds[0], header.bounds[1], header.bounds[2]),
+		DirectX::XMFLOAT3(header.bounds[3], header.bounds[4], header.bounds[5]));
+	dag->words.swap(words);
+
+	return true;
+}
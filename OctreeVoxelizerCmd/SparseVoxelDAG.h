@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "BoundingBox3D.h"
+#include "LinearOctree.h"
+
+// Sparse voxel DAG: a linear octree with identical subtrees merged.
+//
+// A node is one header word followed by one word per child that is present
+// but not complete, in octant order, holding that child's word offset. The
+// header's low byte is the child mask and the next byte the mask of complete
+// children, which are not stored at all. An encoding describes a shape
+// relative to its own cell, so nodes are shared across levels as well.
+
+struct SparseVoxelDAG {
+	static const uint32_t EmptyRoot = 0xffffffff; // nothing occupied
+	static const uint32_t FullRoot = 0xfffffffe;  // the whole box occupied
+
+	BoundingBox3D boundingBox;
+	int depth = 0;
+	uint32_t root = EmptyRoot; // word offset of the root node
+	std::vector<uint32_t> words;
+
+	size_t SizeInBytes() const { return words.size() * sizeof(uint32_t); }
+};
+
+inline uint8_t DAGChildMask(uint32_t header) { return header & 0xff; }
+inline uint8_t DAGCompleteMask(uint32_t header) { return (header >> 8) & 0xff; }
+
+SparseVoxelDAG* createSparseVoxelDAG(const LinearOctree* octree);
+
+// Same boxes, in the same order, as BuildLinearOctreeGeometry on the source octree.
+void BuildSparseVoxelDAGGeometry(const SparseVoxelDAG* dag, std::vector<BoundingBox3D>& boxGeometries);
+
+// True if the cell with Morton code at level (0 is the root) is occupied.
+bool IsSparseVoxelDAGCellOccupied(const SparseVoxelDAG* dag, uint64_t code, int level);
+
+// Versioned little-endian blob: header, bounding box, then the words.
+// Deserializing checks every node and child offset, and returns false without
+// touching dag if the blob is truncated or corrupt.
+void SerializeSparseVoxelDAG(const SparseVoxelDAG* dag, std::vector<uint8_t>& bytes);
+bool DeserializeSparseVoxelDAG(const uint8_t* bytes, size_t size, SparseVoxelDAG* dag);
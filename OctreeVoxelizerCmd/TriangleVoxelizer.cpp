@@ -0,0 +1,276 @@
+#include "TriangleVoxelizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+// Cells are padded by this fraction of their size in conservative mode.
+static const float ConservativePadding = 1e-4f;
+
+static inline XMFLOAT3 sub(const XMFLOAT3& a, const XMFLOAT3& b) { return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z); }
+static inline float dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+static inline XMFLOAT3 cross(const XMFLOAT3& a, const XMFLOAT3& b) { return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x); }
+
+// True if axis separates the triangle (relative to the box center) from the box.
+static inline bool isSeparatingAxis(const XMFLOAT3& axis, const XMFLOAT3 v[3], const XMFLOAT3& halfSize, bool conservative)
+{
+	// Edge cross products vanish for edges parallel to a box axis.
+	if (dot(axis, axis) < 1e-20f)
+		return false;
+
+	const float p0 = dot(axis, v[0]), p1 = dot(axis, v[1]), p2 = dot(axis, v[2]);
+	const float pMin = std::min(p0, std::min(p1, p2));
+	const float pMax = std::max(p0, std::max(p1, p2));
+	const float r = halfSize.x * std::fabs(axis.x) + halfSize.y * std::fabs(axis.y) + halfSize.z * std::fabs(axis.z);
+
+	return conservative ? (pMin > r || pMax < -r) : (pMin >= r || pMax <= -r);
+}
+
+bool TriangleBoxOverlap(const XMFLOAT3& center, const XMFLOAT3& halfSize, const XMFLOAT3 triangle[3], bool conservative)
+{
+	const XMFLOAT3 v[3] = { sub(triangle[0], center), sub(triangle[1], center), sub(triangle[2], center) };
+	const XMFLOAT3 edges[3] = { sub(v[1], v[0]), sub(v[2], v[1]), sub(v[0], v[2]) };
+	const XMFLOAT3 boxAxes[3] = { XMFLOAT3(1, 0, 0), XMFLOAT3(0, 1, 0), XMFLOAT3(0, 0, 1) };
+
+	// Box face normals, i.e. the triangle's bounding box against the cell.
+	for (int i = 0; i < 3; ++i) {
+		if (isSeparatingAxis(boxAxes[i], v, halfSize, conservative))
+			return false;
+	}
+
+	// Triangle plane.
+	if (isSeparatingAxis(cross(edges[0], edges[1]), v, halfSize, conservative))
+		return false;
+
+	// Edge / box axis cross products.
+	for (int e = 0; e < 3; ++e) {
+		for (int i = 0; i < 3; ++i) {
+			if (isSeparatingAxis(cross(edges[e], boxAxes[i]), v, halfSize, conservative))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+void VoxelizeTriangles(const BoundingBox3D& grid, int depth, const std::vector<float>& positions, const std::vector<unsigned int>& indices, bool conservative, std::vector<uint64_t>& leafCodes)
+{
+	assert(depth > 0 && depth <= LinearOctree::MaxDepth);
+	assert(indices.size() % 3 == 0);
+
+	const int last = (1 << depth) - 1;
+	const float cells = static_cast<float>(1 << depth);
+	const float* pMin = &grid.Min.x;
+	const float* pMax = &grid.Max.x;
+
+	// A flat axis maps everything to cell 0 and never separates.
+	float cellSize[3], scale[3];
+	for (int axis = 0; axis < 3; ++axis) {
+		const float extent = pMax[axis] - pMin[axis];
+		cellSize[axis] = extent > 0 ? extent / cells : 0.f;
+		scale[axis] = extent > 0 ? cells / extent : 0.f;
+	}
+
+	const float padding = conservative ? ConservativePadding : 0.f;
+	const XMFLOAT3 halfSize(
+		cellSize[0] > 0 ? cellSize[0] * (0.5f + padding) : 1.f,
+		cellSize[1] > 0 ? cellSize[1] * (0.5f + padding) : 1.f,
+		cellSize[2] > 0 ? cellSize[2] * (0.5f + padding) : 1.f);
+
+	for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+		XMFLOAT3 triangle[3];
+		for (int k = 0; k < 3; ++k) {
+			const float* p = positions.data() + 3 * static_cast<size_t>(indices[t + k]);
+			triangle[k] = XMFLOAT3(p[0], p[1], p[2]);
+		}
+
+		// Bin the triangle by its bounding box first; only cells inside it are candidates.
+		int lo[3], hi[3];
+		for (int axis = 0; axis < 3; ++axis) {
+			const float* c0 = &triangle[0].x;
+			const float* c1 = &triangle[1].x;
+			const float* c2 = &triangle[2].x;
+			const float tMin = (std::min(c0[axis], std::min(c1[axis], c2[axis])) - pMin[axis]) * scale[axis] - padding;
+			const float tMax = (std::max(c0[axis], std::max(c1[axis], c2[axis])) - pMin[axis]) * scale[axis] + padding;
+
+			lo[axis] = std::min(std::max(static_cast<int>(std::floor(tMin)), 0), last);
+			hi[axis] = std::min(std::max(static_cast<int>(std::floor(tMax)), 0), last);
+		}
+
+		// Fast path: the triangle lies in one cell, nothing to test.
+		if (lo[0] == hi[0] && lo[1] == hi[1] && lo[2] == hi[2]) {
+			leafCodes.push_back(EncodeMorton3(lo[0], lo[1], lo[2]));
+			continue;
+		}
+
+		for (int z = lo[2]; z <= hi[2]; ++z) {
+			for (int y = lo[1]; y <= hi[1]; ++y) {
+				for (int x = lo[0]; x <= hi[0]; ++x) {
+					const XMFLOAT3 center(
+						pMin[0] + (x + 0.5f) * cellSize[0],
+						pMin[1] + (y + 0.5f) * cellSize[1],
+						pMin[2] + (z + 0.5f) * cellSize[2]);
+
+					if (TriangleBoxOverlap(center, halfSize, triangle, conservative)) {
+						leafCodes.push_back(EncodeMorton3(x, y, z));
+					}
+				}
+			}
+		}
+	}
+}
+
+struct ColumnCrossing {
+	uint32_t column; // y * cells + x
+	float z;
+
+	bool operator<(const ColumnCrossing& other) const { return column != other.column ? column < other.column : z < other.z; }
+};
+
+static inline float edgeFunction(const XMFLOAT3& a, const XMFLOAT3& b, float px, float py)
+{
+	return (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+}
+
+// Top-left rule for counter-clockwise edges, so a column through a shared
+// edge or vertex is counted by exactly one of the triangles meeting there.
+static inline bool isTopLeftEdge(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+	return b.y < a.y || (b.y == a.y && b.x < a.x);
+}
+
+static inline bool insideEdge(float w, const XMFLOAT3& a, const XMFLOAT3& b)
+{
+	return w > 0 || (w == 0 && isTopLeftEdge(a, b));
+}
+
+void VoxelizeTriangles(VoxelGrid& grid, const std::vector<float>& positions, const std::vector<unsigned int>& indices, bool conservative)
+{
+	std::vector<uint64_t> codes;
+	VoxelizeTriangles(grid.boundingBox, grid.depth, positions, indices, conservative, codes);
+
+	for (uint64_t code : codes) {
+		grid.Set(code);
+	}
+}
+
+void VoxelizeTrianglesSolid(VoxelGrid& grid, const std::vector<float>& positions, const std::vector<unsigned int>& indices)
+{
+	const int depth = grid.depth;
+	const int cells = 1 << depth;
+	const float* pMin = &grid.boundingBox.Min.x;
+	const float* pMax = &grid.boundingBox.Max.x;
+
+	VoxelizeTriangles(grid, positions, indices, true);
+
+	float cellSize[3];
+	for (int axis = 0; axis < 3; ++axis) {
+		cellSize[axis] = (pMax[axis] - pMin[axis]) / cells;
+	}
+
+	// A flat mesh has no interior.
+	if (!(cellSize[0] > 0 && cellSize[1] > 0 && cellSize[2] > 0))
+		return;
+
+	// Cast a ray along z through every column center and record where it
+	// crosses each triangle.
+	std::vector<ColumnCrossing> crossings;
+
+	for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+		const float* p0 = positions.data() + 3 * static_cast<size_t>(indices[t]);
+		const float* p1 = positions.data() + 3 * static_cast<size_t>(indices[t + 1]);
+		const float* p2 = positions.data() + 3 * static_cast<size_t>(indices[t + 2]);
+		XMFLOAT3 a(p0[0], p0[1], p0[2]), b(p1[0], p1[1], p1[2]), c(p2[0], p2[1], p2[2]);
+
+		float area = edgeFunction(a, b, c.x, c.y);
+		if (area == 0)
+			continue; // parallel to the rays
+		if (area < 0) {
+			std::swap(b, c);
+			area = -area;
+		}
+
+		// Columns whose centers fall inside the triangle's xy bounds.
+		const int x0 = std::max(static_cast<int>(std::ceil((std::min(a.x, std::min(b.x, c.x)) - pMin[0]) / cellSize[0] - 0.5f)), 0);
+		const int x1 = std::min(static_cast<int>(std::floor((std::max(a.x, std::max(b.x, c.x)) - pMin[0]) / cellSize[0] - 0.5f)), cells - 1);
+		const int y0 = std::max(static_cast<int>(std::ceil((std::min(a.y, std::min(b.y, c.y)) - pMin[1]) / cellSize[1] - 0.5f)), 0);
+		const int y1 = std::min(static_cast<int>(std::floor((std::max(a.y, std::max(b.y, c.y)) - pMin[1]) / cellSize[1] - 0.5f)), cells - 1);
+
+		for (int y = y0; y <= y1; ++y) {
+			const float py = pMin[1] + (y + 0.5f) * cellSize[1];
+
+			for (int x = x0; x <= x1; ++x) {
+				const float px = pMin[0] + (x + 0.5f) * cellSize[0];
+				const float wa = edgeFunction(b, c, px, py);
+				const float wb = edgeFunction(c, a, px, py);
+				const float wc = edgeFunction(a, b, px, py);
+
+				if (insideEdge(wa, b, c) && insideEdge(wb, c, a) && insideEdge(wc, a, b)) {
+					ColumnCrossing crossing = { static_cast<uint32_t>(y) * cells + x, (wa * a.z + wb * b.z + wc * c.z) / area };
+					crossings.push_back(crossing);
+				}
+			}
+		}
+	}
+
+	std::sort(crossings.begin(), crossings.end());
+
+	// Fill the cells whose centers lie between each entering and leaving crossing.
+	for (size_t begin = 0; begin < crossings.size();) {
+		size_t end = begin;
+		while (end < crossings.size() && crossings[end].column == crossings[begin].column) {
+			++end;
+		}
+
+		const int x = crossings[begin].column % cells;
+		const int y = crossings[begin].column / cells;
+
+		for (size_t i = begin; i + 1 < end; i += 2) {
+			const int z0 = std::max(static_cast<int>(std::ceil((crossings[i].z - pMin[2]) / cellSize[2] - 0.5f)), 0);
+			const int z1 = std::min(static_cast<int>(std::floor((crossings[i + 1].z - pMin[2]) / cellSize[2] - 0.5f)), cells - 1);
+
+			for (int z = z0; z <= z1; ++z) {
+				grid.Set(EncodeMorton3(x, y, z));
+			}
+		}
+
+		begin = end;
+	}
+}
+
+LinearOctree* createLinearOctreeFromTriangles(const std::vector<float>& positions, const std::vector<unsigned int>& indices, int depth, bool conservative)
+{
+	LinearOctree* octree = new LinearOctree();
+	octree->depth = depth;
+
+	for (size_t i = 0; i + 2 < positions.size(); i += 3) {
+		octree->boundingBox.AddPoint(XMFLOAT3(positions[i], positions[i + 1], positions[i + 2]));
+	}
+
+	std::vector<uint64_t> codes;
+	VoxelizeTriangles(octree->boundingBox, depth, positions, indices, conservative, codes);
+
+	std::sort(codes.begin(), codes.end());
+	codes.erase(std::unique(codes.begin(), codes.end()), codes.end());
+
+	BuildLinearOctreeLevels(octree, codes);
+
+	return octree;
+}
+
+LinearOctree* createSolidLinearOctreeFromTriangles(const std::vector<float>& positions, const std::vector<unsigned int>& indices, int depth)
+{
+	BoundingBox3D boundingBox;
+
+	for (size_t i = 0; i + 2 < positions.size(); i += 3) {
+		boundingBox.AddPoint(XMFLOAT3(positions[i], positions[i + 1], positions[i + 2]));
+	}
+
+	VoxelGrid grid;
+	grid.Resize(boundingBox, depth);
+	VoxelizeTrianglesSolid(grid, positions, indices);
+
+	return createLinearOctreeFromGrid(grid);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "BoundingBox3D.h"
+#include "LinearOctree.h"
+#include "VoxelGrid.h"
+
+// Surface voxelization of indexed triangles. A cell is occupied if a triangle
+// overlaps it (separating axis test), not only if a vertex lands inside it.
+// Conservative mode counts touching as overlap and pads every cell by a small
+// fraction of its size, so no cell a triangle grazes is lost to rounding.
+
+bool TriangleBoxOverlap(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& halfSize, const DirectX::XMFLOAT3 triangle[3], bool conservative);
+
+// Appends the leaf codes (at depth, over grid) of every cell overlapped by a
+// triangle. Codes are neither sorted nor unique.
+void VoxelizeTriangles(const BoundingBox3D& grid, int depth, const std::vector<float>& positions, const std::vector<unsigned int>& indices, bool conservative, std::vector<uint64_t>& leafCodes);
+
+// Sets the cells of VoxelizeTriangles over the grid's box and depth.
+void VoxelizeTriangles(VoxelGrid& grid, const std::vector<float>& positions, const std::vector<unsigned int>& indices, bool conservative);
+
+// Solid voxelization: the conservative surface plus every cell whose center
+// is inside the mesh, found by ray parity along z for each column of cells.
+// The mesh must be watertight; a hole lets a column leak.
+void VoxelizeTrianglesSolid(VoxelGrid& grid, const std::vector<float>& positions, const std::vector<unsigned int>& indices);
+
+// positions is xyz per vertex (tinyobj attrib_t::vertices), indices three per triangle.
+LinearOctree* createLinearOctreeFromTriangles(const std::vector<float>& positions, const std::vector<unsigned int>& indices, int depth, bool conservative = false);
+
+// Solid counterpart of createLinearOctreeFromTriangles. Filled interiors
+// collapse into complete nodes; depth is limited to VoxelGrid::MaxDepth.
+LinearOctree* createSolidLinearOctreeFromTriangles(const std::vector<float>& positions, const std::vector<unsigned int>& indices, int depth);
+
+// Flattens the vertex indices of tinyobj shapes, loaded with triangulation on,
+// into one triangle list.
+template <typename Shape>
+void AppendTriangleIndices(const std::vector<Shape>& shapes, std::vector<unsigned int>& indices)
+{
+	for (const auto& shape : shapes) {
+		for (const auto& index : shape.mesh.indices) {
+			indices.push_back(static_cast<unsigned int>(index.vertex_index));
+		}
+	}
+}
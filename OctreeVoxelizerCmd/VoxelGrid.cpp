@@ -0,0 +1,327 @@
+#include "VoxelGrid.h"
+
+#include <algorithm>
+#include <cassert>
+#include <ppl.h>
+
+#if defined(_M_X64) || defined(_M_ARM64)
+#include <intrin.h>
+#endif
+
+using namespace DirectX;
+
+void VoxelGrid::Resize(const BoundingBox3D& box, int depth)
+{
+	assert(depth > 0 && depth <= MaxDepth);
+
+	this->boundingBox = box;
+	this->depth = depth;
+	bits.assign(static_cast<size_t>((CellCount() + 63) / 64), 0);
+}
+
+static inline bool testBit(const VoxelGrid::Bits& bits, uint64_t index)
+{
+	return (bits[index >> 6] >> (index & 63)) & 1;
+}
+
+static inline uint8_t childByte(const VoxelGrid::Bits& bits, uint64_t code)
+{
+	return static_cast<uint8_t>(bits[code >> 3] >> ((code & 7) * 8));
+}
+
+LinearOctree* createLinearOctreeFromGrid(const VoxelGrid& grid)
+{
+	const int depth = grid.depth;
+
+	// Per level occupancy (any child set) and fullness (all children full),
+	// reduced bottom-up a byte at a time. Level depth is the grid itself.
+	std::vector<VoxelGrid::Bits> occupied(depth), full(depth);
+
+	for (int level = depth - 1; level >= 0; --level) {
+		const VoxelGrid::Bits& childOccupied = level + 1 == depth ? grid.bits : occupied[level + 1];
+		const VoxelGrid::Bits& childFull = level + 1 == depth ? grid.bits : full[level + 1];
+		const uint64_t cells = 1ull << (3 * level);
+
+		occupied[level].assign(static_cast<size_t>((cells + 63) / 64), 0);
+		full[level].assign(static_cast<size_t>((cells + 63) / 64), 0);
+
+		for (uint64_t code = 0; code < cells; ++code) {
+			if (childByte(childOccupied, code) != 0) {
+				occupied[level][code >> 6] |= 1ull << (code & 63);
+			}
+			if (childByte(childFull, code) == 0xff) {
+				full[level][code >> 6] |= 1ull << (code & 63);
+			}
+		}
+	}
+
+	LinearOctree* octree = new LinearOctree();
+	octree->boundingBox = grid.boundingBox;
+	octree->depth = depth;
+	octree->levelOffsets.assign(depth + 2, 0);
+
+	const bool rootOccupied = depth == 0 ? testBit(grid.bits, 0) : testBit(occupied[0], 0);
+	if (!rootOccupied) {
+		return octree;
+	}
+
+	LinearOctreeNode root = { 0, 0, 0, false };
+	octree->nodes.push_back(root);
+	octree->levelOffsets[1] = 1;
+
+	// Top-down: children are appended in octant order behind sorted parents,
+	// so every level comes out sorted by code.
+	for (int level = 0; level <= depth; ++level) {
+		const uint32_t begin = octree->levelOffsets[level];
+		const uint32_t end = octree->levelOffsets[level + 1];
+
+		for (uint32_t i = begin; i < end; ++i) {
+			const uint64_t code = octree->nodes[i].code;
+
+			if (level == depth || testBit(full[level], code)) {
+				octree->nodes[i].isCompleteSubtree = true;
+				continue;
+			}
+
+			const VoxelGrid::Bits& childOccupied = level + 1 == depth ? grid.bits : occupied[level + 1];
+
+			octree->nodes[i].firstChild = static_cast<uint32_t>(octree->nodes.size());
+			for (uint32_t octant = 0; octant < 8; ++octant) {
+				const uint64_t childCode = (code << 3) | octant;
+
+				if (testBit(childOccupied, childCode)) {
+					LinearOctreeNode child = { childCode, 0, 0, false };
+					octree->nodes.push_back(child);
+					octree->nodes[i].childMask |= 1 << octant;
+				}
+			}
+		}
+
+		if (level < depth) {
+			octree->levelOffsets[level + 2] = static_cast<uint32_t>(octree->nodes.size());
+		}
+	}
+
+	return octree;
+}
+
+void FillVoxelGrid(VoxelGrid& grid, const LinearOctree* octree)
+{
+	assert(grid.depth == octree->depth);
+
+	for (int level = 0; level <= octree->depth; ++level) {
+		for (uint32_t i = octree->levelOffsets[level]; i < octree->levelOffsets[level + 1]; ++i) {
+			const LinearOctreeNode& node = octree->nodes[i];
+
+			if (!node.isCompleteSubtree || node.childMask != 0)
+				continue;
+
+			// A subtree is a contiguous run of 8^(depth - level) leaf codes.
+			const int shift = 3 * (octree->depth - level);
+			const uint64_t first = node.code << shift;
+
+			if (shift >= 6) {
+				std::fill(grid.bits.begin() + static_cast<size_t>(first >> 6), grid.bits.begin() + static_cast<size_t>((first >> 6) + (1ull << (shift - 6))), ~0ull);
+			}
+			else {
+				grid.bits[first >> 6] |= ((1ull << (1 << shift)) - 1) << (first & 63);
+			}
+		}
+	}
+}
+
+static inline uint64_t popcount(uint64_t x)
+{
+#if defined(_M_X64)
+	return __popcnt64(x);
+#elif defined(_M_ARM64)
+	return _CountOneBits64(x);
+#else
+	x = x - ((x >> 1) & 0x5555555555555555ull);
+	x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+	x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+	return (x * 0x0101010101010101ull) >> 56;
+#endif
+}
+
+void VoxelGrid::Union(const VoxelGrid& other)
+{
+	assert(other.depth == depth && other.bits.size() == bits.size());
+
+	for (size_t i = 0; i < bits.size(); ++i) {
+		bits[i] |= other.bits[i];
+	}
+}
+
+void VoxelGrid::Intersect(const VoxelGrid& other)
+{
+	assert(other.depth == depth && other.bits.size() == bits.size());
+
+	for (size_t i = 0; i < bits.size(); ++i) {
+		bits[i] &= other.bits[i];
+	}
+}
+
+void VoxelGrid::Subtract(const VoxelGrid& other)
+{
+	assert(other.depth == depth && other.bits.size() == bits.size());
+
+	for (size_t i = 0; i < bits.size(); ++i) {
+		bits[i] &= ~other.bits[i];
+	}
+}
+
+// Within a brick word, cell (x, y, z) is bit x0 | y0 << 1 | z0 << 2 | x1 << 3
+// | y1 << 4 | z1 << 5. layers[axis][v] holds the cells whose coordinate
+// along axis is v.
+struct BrickLayers {
+	uint64_t layers[3][4];
+
+	BrickLayers() {
+		for (int axis = 0; axis < 3; ++axis) {
+			for (int v = 0; v < 4; ++v) {
+				layers[axis][v] = 0;
+			}
+			for (int bit = 0; bit < 64; ++bit) {
+				const int v = ((bit >> axis) & 1) | (((bit >> (axis + 3)) & 1) << 1);
+				layers[axis][v] |= 1ull << bit;
+			}
+		}
+	}
+};
+
+// The cells of brick word w moved one cell up (+1) along axis; previous is
+// the word of the brick below, whose top layer moves in.
+static inline uint64_t shiftUp(const BrickLayers& b, int axis, uint64_t w, uint64_t previous)
+{
+	const int s = 1 << axis, t = 1 << (axis + 3);
+	const uint64_t* layer = b.layers[axis];
+
+	return ((w & (layer[0] | layer[2])) << s) | ((w & layer[1]) << (t - s)) | ((previous & layer[3]) >> (s + t));
+}
+
+// Moved one cell down; next is the word of the brick above.
+static inline uint64_t shiftDown(const BrickLayers& b, int axis, uint64_t w, uint64_t next)
+{
+	const int s = 1 << axis, t = 1 << (axis + 3);
+	const uint64_t* layer = b.layers[axis];
+
+	return ((w & (layer[1] | layer[3])) >> s) | ((w & layer[2]) >> (t - s)) | ((next & layer[0]) << (s + t));
+}
+
+// Word indices are the Morton codes of the bricks, so the brick next to k
+// along an axis is a masked increment or decrement of k's bits on that axis.
+// axisBits[axis] holds those bits.
+template <bool Dilation>
+static inline uint64_t morphologyWord(const VoxelGrid::Bits& in, uint64_t k, const uint64_t* axisBits)
+{
+	static const BrickLayers bricks;
+
+	const uint64_t w = in[static_cast<size_t>(k)];
+	uint64_t result = w;
+
+	for (int axis = 0; axis < 3; ++axis) {
+		const uint64_t mask = axisBits[axis];
+		const uint64_t along = k & mask;
+		const uint64_t rest = k & ~mask;
+
+		const uint64_t below = along != 0 ? in[static_cast<size_t>(((along - 1) & mask) | rest)] : 0;
+		const uint64_t above = along != mask ? in[static_cast<size_t>((((along | ~mask) + 1) & mask) | rest)] : 0;
+
+		// Dilation adds the cells next to an occupied cell; erosion keeps
+		// the cells whose neighbours on both sides are occupied.
+		if (Dilation) {
+			result |= shiftUp(bricks, axis, w, below) | shiftDown(bricks, axis, w, above);
+		}
+		else {
+			result &= shiftUp(bricks, axis, w, below) & shiftDown(bricks, axis, w, above);
+		}
+	}
+
+	return result;
+}
+
+// One dilation (or erosion) step of every word of in into out, a chunk of
+// words per task. A depth-1 grid is a single brick with only its low 2x2x2
+// cells inside the grid.
+template <bool Dilation>
+static void morphologyStep(const VoxelGrid::Bits& in, VoxelGrid::Bits& out, int depth)
+{
+	const size_t words = in.size();
+	const size_t chunkWords = 4096;
+	const uint64_t inside = depth >= 2 ? ~0ull : 0xffull;
+
+	uint64_t axisBits[3];
+	for (int axis = 0; axis < 3; ++axis) {
+		axisBits[axis] = (0x1249249249249249ull << axis) & (words - 1);
+	}
+
+	concurrency::parallel_for(size_t(0), (words + chunkWords - 1) / chunkWords, [&](size_t chunk) {
+		const size_t last = std::min(words, (chunk + 1) * chunkWords);
+
+		for (size_t k = chunk * chunkWords; k < last; ++k) {
+			out[k] = morphologyWord<Dilation>(in, k, axisBits) & inside;
+		}
+	});
+}
+
+void VoxelGrid::Dilate(int steps)
+{
+	Bits next(bits.size());
+
+	for (int step = 0; step < steps; ++step) {
+		morphologyStep<true>(bits, next, depth);
+		bits.swap(next);
+	}
+}
+
+void VoxelGrid::Erode(int steps)
+{
+	Bits next(bits.size());
+
+	for (int step = 0; step < steps; ++step) {
+		morphologyStep<false>(bits, next, depth);
+		bits.swap(next);
+	}
+}
+
+uint64_t VoxelGrid::CountOccupied() const
+{
+	uint64_t count = 0;
+
+	for (uint64_t word : bits) {
+		count += popcount(word);
+	}
+
+	return count;
+}
+
+VoxelGridStats VoxelGrid::ComputeStats() const
+{
+	VoxelGridStats stats = {};
+
+	Bits eroded(bits.size());
+	morphologyStep<false>(bits, eroded, depth);
+
+	for (size_t line = 0; line < bits.size(); line += 8) {
+		uint64_t any = 0;
+
+		for (size_t k = line; k < std::min(line + 8, bits.size()); ++k) {
+			stats.occupiedCells += popcount(bits[k]);
+			stats.surfaceCells += popcount(bits[k] & ~eroded[k]);
+			stats.occupiedBricks += bits[k] != 0;
+			any |= bits[k];
+		}
+
+		stats.occupiedCacheLines += any != 0;
+	}
+
+	return stats;
+}
+
+void VoxelizePoints(VoxelGrid& grid, const std::vector<XMFLOAT3*>& vertices)
+{
+	for (const auto* vertex : vertices) {
+		grid.Set(GridPointCode(grid.boundingBox, grid.depth, *vertex));
+	}
+}
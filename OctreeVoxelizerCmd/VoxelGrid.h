@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <malloc.h>
+#include <new>
+#include <vector>
+
+#include "BoundingBox3D.h"
+#include "LinearOctree.h"
+
+// Dense occupancy grid at one bit per leaf cell. Bits are stored in Morton
+// order, so every 64-bit word is a 4x4x4 brick, every cache line an 8x8x8
+// block, and the eight children of a cell one level up are one byte.
+//
+// Set operations work a word at a time. Dilation and erosion shift whole
+// bricks along each axis with masks and take the cells that cross a brick
+// face from the neighbouring brick's word.
+
+// Storage aligned to a cache line, so no 8x8x8 block straddles two lines.
+template <typename T>
+struct CacheLineAllocator {
+	typedef T value_type;
+	static const size_t Alignment = 64;
+
+	CacheLineAllocator() {}
+	template <typename U> CacheLineAllocator(const CacheLineAllocator<U>&) {}
+
+	T* allocate(size_t count) {
+		void* p = _aligned_malloc(count * sizeof(T), Alignment);
+		if (!p)
+			throw std::bad_alloc();
+		return static_cast<T*>(p);
+	}
+	void deallocate(T* p, size_t) { _aligned_free(p); }
+
+	template <typename U> bool operator==(const CacheLineAllocator<U>&) const { return true; }
+	template <typename U> bool operator!=(const CacheLineAllocator<U>&) const { return false; }
+};
+
+struct VoxelGridStats {
+	uint64_t occupiedCells;
+	uint64_t occupiedBricks;     // 4x4x4 words with a cell set
+	uint64_t occupiedCacheLines; // 8x8x8 blocks with a cell set
+	uint64_t surfaceCells;       // occupied cells with an empty face neighbour, or on the grid's border
+};
+
+struct VoxelGrid {
+	static const int MaxDepth = 10; // 2^30 cells, 128 MB
+
+	typedef std::vector<uint64_t, CacheLineAllocator<uint64_t>> Bits;
+
+	BoundingBox3D boundingBox;
+	int depth = 0;
+	Bits bits;
+
+	void Resize(const BoundingBox3D& box, int depth);
+
+	uint64_t CellCount() const { return 1ull << (3 * depth); }
+	void Set(uint64_t code) { bits[code >> 6] |= 1ull << (code & 63); }
+	bool Test(uint64_t code) const { return (bits[code >> 6] >> (code & 63)) & 1; }
+
+	// Both grids must have the same box and depth.
+	void Union(const VoxelGrid& other);
+	void Intersect(const VoxelGrid& other);
+	void Subtract(const VoxelGrid& other);
+
+	// Grows or shrinks the occupied cells by steps cells across faces
+	// (6-connected). Cells outside the grid count as empty.
+	void Dilate(int steps = 1);
+	void Erode(int steps = 1);
+
+	uint64_t CountOccupied() const;
+	VoxelGridStats ComputeStats() const;
+};
+
+// Sets the cell of every vertex, clamped to the grid like LinearOctree::PointCode.
+// The grid keeps its box; resize it to the vertices' box for the cells
+// createLinearOctree(vertices, depth) would have.
+void VoxelizePoints(VoxelGrid& grid, const std::vector<DirectX::XMFLOAT3*>& vertices);
+
+// Builds a linear octree over the grid's box and depth. Complete subtrees are
+// pruned: a complete node above the leaf level keeps childMask 0.
+LinearOctree* createLinearOctreeFromGrid(const VoxelGrid& grid);
+
+// Inverse of createLinearOctreeFromGrid: sets the cells of every complete node.
+// grid must have been resized to the octree's box and depth.
+void FillVoxelGrid(VoxelGrid& grid, const LinearOctree* octree);
@@ -0,0 +1,75 @@
+#include "VoxelHashTable.h"
+
+VoxelHashTable::VoxelHashTable(size_t expectedSize)
+	: size(0), shift(64)
+{
+	size_t capacity = 16;
+	while (capacity < 2 * expectedSize) {
+		capacity *= 2;
+	}
+
+	for (size_t c = capacity; c > 1; c >>= 1) {
+		--shift;
+	}
+
+	keys.assign(capacity, EmptyKey);
+	values.assign(capacity, NoValue);
+}
+
+uint32_t VoxelHashTable::FindOrInsert(uint64_t key, uint32_t value, bool& inserted)
+{
+	const size_t mask = keys.size() - 1;
+
+	for (size_t slot = Slot(key); ; slot = (slot + 1) & mask) {
+		if (keys[slot] == key) {
+			inserted = false;
+			return values[slot];
+		}
+
+		if (keys[slot] == EmptyKey) {
+			keys[slot] = key;
+			values[slot] = value;
+			inserted = true;
+
+			if (2 * ++size > keys.size()) {
+				Grow();
+			}
+			return value;
+		}
+	}
+}
+
+uint32_t VoxelHashTable::Find(uint64_t key) const
+{
+	const size_t mask = keys.size() - 1;
+
+	for (size_t slot = Slot(key); keys[slot] != EmptyKey; slot = (slot + 1) & mask) {
+		if (keys[slot] == key)
+			return values[slot];
+	}
+
+	return NoValue;
+}
+
+void VoxelHashTable::Grow()
+{
+	std::vector<uint64_t> oldKeys(2 * keys.size(), EmptyKey);
+	std::vector<uint32_t> oldValues(2 * values.size(), NoValue);
+	oldKeys.swap(keys);
+	oldValues.swap(values);
+	--shift;
+
+	const size_t mask = keys.size() - 1;
+
+	for (size_t i = 0; i < oldKeys.size(); ++i) {
+		if (oldKeys[i] == EmptyKey)
+			continue;
+
+		size_t slot = Slot(oldKeys[i]);
+		while (keys[slot] != EmptyKey) {
+			slot = (slot + 1) & mask;
+		}
+		keys[slot] = oldKeys[i];
+		values[slot] = oldValues[i];
+	}
+}
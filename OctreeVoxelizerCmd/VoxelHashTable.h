@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Open addressing from 64-bit keys, such as packed cell or edge keys, to
+// 32-bit values, with linear probing at a load factor of at most one half.
+class VoxelHashTable {
+public:
+	static const uint64_t EmptyKey = ~0ull; // never a packed cell key
+	static const uint32_t NoValue = 0xffffffff;
+
+	explicit VoxelHashTable(size_t expectedSize = 1024);
+
+	// The value of key, after storing value for it if it was absent.
+	uint32_t FindOrInsert(uint64_t key, uint32_t value, bool& inserted);
+	uint32_t Find(uint64_t key) const; // NoValue if absent
+
+	size_t Size() const { return size; }
+
+private:
+	std::vector<uint64_t> keys;
+	std::vector<uint32_t> values;
+	size_t size;
+	int shift; // 64 - log2(capacity)
+
+	size_t Slot(uint64_t key) const { return static_cast<size_t>((key * 0x9e3779b97f4a7c15ull) >> shift); }
+	void Grow();
+};
@@ -0,0 +1,160 @@
+#include "VoxelLodPyramid.h"
+
+#include <algorithm>
+#include <cassert>
+
+// Levels[first, last] of every entry, filled with one counting sort so each
+// level comes out in entry order.
+template <typename Range, typename Box>
+static void FillLevels(VoxelLodPyramid* pyramid, int levelCount, size_t entryCount, Range range, Box box)
+{
+	std::vector<uint32_t> counts(levelCount + 1, 0);
+
+	for (size_t i = 0; i < entryCount; ++i) {
+		int first, last;
+		range(i, first, last);
+		for (int level = first; level <= last; ++level) {
+			++counts[level + 1];
+		}
+	}
+
+	pyramid->levelOffsets.assign(levelCount + 1, 0);
+	for (int level = 0; level < levelCount; ++level) {
+		pyramid->levelOffsets[level + 1] = pyramid->levelOffsets[level] + counts[level + 1];
+	}
+
+	pyramid->boxes.resize(pyramid->levelOffsets[levelCount]);
+	std::vector<uint32_t> next(pyramid->levelOffsets.begin(), pyramid->levelOffsets.end() - 1);
+
+	for (size_t i = 0; i < entryCount; ++i) {
+		int first, last;
+		range(i, first, last);
+		if (first > last)
+			continue;
+
+		const BoundingBox3D entryBox = box(i);
+		for (int level = first; level <= last; ++level) {
+			pyramid->boxes[next[level]++] = entryBox;
+		}
+	}
+}
+
+VoxelLodPyramid* createVoxelLodPyramid(const LinearOctree* octree)
+{
+	VoxelLodPyramid* pyramid = new VoxelLodPyramid();
+	const int depth = octree->depth;
+
+	if (octree->nodes.empty()) {
+		pyramid->levelOffsets.assign(depth + 2, 0);
+		return pyramid;
+	}
+
+	const uint32_t count = static_cast<uint32_t>(octree->nodes.size());
+
+	// Every node is complete when the tree is cut at its own level, and stays
+	// complete up to lastComplete: the full depth for a complete node, else the
+	// shallowest lastComplete of its children if it has all eight of them.
+	std::vector<int> levels(count), lastComplete(count);
+	std::vector<uint32_t> parents(count, 0);
+
+	for (int level = depth; level >= 0; --level) {
+		for (uint32_t i = octree->levelOffsets[level]; i < octree->levelOffsets[level + 1]; ++i) {
+			const LinearOctreeNode& node = octree->nodes[i];
+			const int children = ChildCount(node.childMask);
+
+			levels[i] = level;
+			lastComplete[i] = node.isCompleteSubtree ? depth : level;
+
+			if (!node.isCompleteSubtree && node.childMask == 0xff) {
+				lastComplete[i] = depth;
+				for (int c = 0; c < 8; ++c) {
+					lastComplete[i] = std::min(lastComplete[i], lastComplete[node.firstChild + c]);
+				}
+			}
+
+			for (int c = 0; c < children; ++c) {
+				parents[node.firstChild + c] = i;
+			}
+		}
+	}
+
+	// A node is a box of level l while it is complete at l and its parent is not.
+	FillLevels(pyramid, depth + 1, count,
+		[&](size_t i, int& first, int& last) {
+			first = i == 0 ? 0 : std::max(levels[i], lastComplete[parents[i]] + 1);
+			last = lastComplete[i];
+		},
+		[&](size_t i) {
+			return octree->NodeBoundingBox(octree->nodes[i].code, levels[i]);
+		});
+
+	return pyramid;
+}
+
+struct BinaryLodEntry {
+	BoundingBox3D box;
+	int depth;
+	bool isLeaf;
+};
+
+// Preorder entries; leaf boxes are the next run of tree->boundingBoxes, inner
+// boxes the union of their children's.
+static BoundingBox3D AddBinaryLodEntries(const BinaryTreeNode* node, int depth, const std::vector<BoundingBox3D>& leafBoxes, size_t& leaf, std::vector<BinaryLodEntry>& entries)
+{
+	const size_t index = entries.size();
+	entries.push_back(BinaryLodEntry());
+
+	BoundingBox3D box;
+
+	if (!node->left) {
+		box = leafBoxes[leaf++];
+	}
+	else {
+		const BoundingBox3D left = AddBinaryLodEntries(node->left, depth + 1, leafBoxes, leaf, entries);
+		const BoundingBox3D right = AddBinaryLodEntries(node->right, depth + 1, leafBoxes, leaf, entries);
+
+		box.AddPoint(left.Min);
+		box.AddPoint(left.Max);
+		box.AddPoint(right.Min);
+		box.AddPoint(right.Max);
+	}
+
+	entries[index].box = box;
+	entries[index].depth = depth;
+	entries[index].isLeaf = !node->left;
+
+	return box;
+}
+
+VoxelLodPyramid* createVoxelLodPyramid(const BinaryTree* tree)
+{
+	VoxelLodPyramid* pyramid = new VoxelLodPyramid();
+
+	if (!tree->rootNode || tree->boundingBoxes.empty()) {
+		pyramid->levelOffsets.assign(2, 0);
+		return pyramid;
+	}
+
+	std::vector<BinaryLodEntry> entries;
+	size_t leaf = 0;
+	AddBinaryLodEntries(tree->rootNode, 0, tree->boundingBoxes, leaf, entries);
+
+	assert(leaf == tree->boundingBoxes.size());
+
+	int maxDepth = 0;
+	for (const auto& entry : entries) {
+		maxDepth = std::max(maxDepth, entry.depth);
+	}
+
+	// An inner node is a box of its own depth only, a leaf of every depth from its own on.
+	FillLevels(pyramid, maxDepth + 1, entries.size(),
+		[&](size_t i, int& first, int& last) {
+			first = entries[i].depth;
+			last = entries[i].isLeaf ? maxDepth : entries[i].depth;
+		},
+		[&](size_t i) {
+			return entries[i].box;
+		});
+
+	return pyramid;
+}
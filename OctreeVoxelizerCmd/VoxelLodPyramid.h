@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "BoundingBox3D.h"
+#include "BinaryTree.h"
+#include "LinearOctree.h"
+
+// The box sets of every level of a tree, built once at its full depth. Level l
+// is the tree cut at depth l: boxes[levelOffsets[l], levelOffsets[l + 1]).
+// Switching levels costs nothing, and the levels together hold about as many
+// boxes as the tree has nodes.
+
+struct VoxelLodPyramid {
+	std::vector<BoundingBox3D> boxes;
+	std::vector<uint32_t> levelOffsets;
+
+	int LevelCount() const { return levelOffsets.empty() ? 0 : static_cast<int>(levelOffsets.size()) - 1; }
+	uint32_t LevelSize(int level) const { return levelOffsets[level + 1] - levelOffsets[level]; }
+	const BoundingBox3D* LevelBoxes(int level) const { return boxes.data() + levelOffsets[level]; }
+};
+
+// Level l has the same boxes as BuildLinearOctreeGeometry on
+// createCoarserLinearOctree(octree, l), not in the same order: a node that is
+// complete at depth l, because all of its cells at l are occupied, is one box.
+VoxelLodPyramid* createVoxelLodPyramid(const LinearOctree* octree);
+
+// Level d is the tree cut at depth d (0 is the root), in depth-first order: a
+// node at depth d stands for the union of its leaves' boxes, shallower leaves
+// keep their own.
+VoxelLodPyramid* createVoxelLodPyramid(const BinaryTree* tree);
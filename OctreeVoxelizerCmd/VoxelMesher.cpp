@@ -0,0 +1,154 @@
+#include "VoxelMesher.h"
+
+#include <algorithm>
+
+#include "Morton.h"
+
+using namespace DirectX;
+
+void BuildVoxelGridMesh(const VoxelGrid& grid, VoxelMesh& mesh, bool greedy)
+{
+	const int cells = 1 << grid.depth;
+
+	// Morton bits of each coordinate, so a code is three lookups and two ors.
+	std::vector<uint64_t> spread(cells);
+	for (int i = 0; i < cells; ++i) {
+		spread[i] = MortonSplitBy3(i);
+	}
+
+	const float* pMin = &grid.boundingBox.Min.x;
+	const float* pMax = &grid.boundingBox.Max.x;
+	float size[3];
+	for (int axis = 0; axis < 3; ++axis) {
+		size[axis] = (pMax[axis] - pMin[axis]) / cells;
+	}
+
+	std::vector<uint8_t> faces(static_cast<size_t>(cells) * cells);
+
+	for (int axis = 0; axis < 3; ++axis) {
+		// (axis, u, v) is a cyclic permutation of (x, y, z), so u x v points along +axis.
+		const int u = (axis + 1) % 3;
+		const int v = (axis + 2) % 3;
+
+		for (int direction = -1; direction <= 1; direction += 2) {
+			for (int slice = 0; slice < cells; ++slice) {
+				const int neighbor = slice + direction;
+				const bool outside = neighbor < 0 || neighbor >= cells;
+				bool any = false;
+
+				for (int j = 0; j < cells; ++j) {
+					for (int i = 0; i < cells; ++i) {
+						const uint64_t rest = spread[i] << u | spread[j] << v;
+						const bool visible = grid.Test(rest | spread[slice] << axis)
+							&& (outside || !grid.Test(rest | spread[neighbor] << axis));
+
+						faces[static_cast<size_t>(j) * cells + i] = visible;
+						any |= visible;
+					}
+				}
+
+				if (!any)
+					continue;
+
+				const float plane = pMin[axis] + (direction > 0 ? slice + 1 : slice) * size[axis];
+
+				for (int j = 0; j < cells; ++j) {
+					for (int i = 0; i < cells; ++i) {
+						if (!faces[static_cast<size_t>(j) * cells + i])
+							continue;
+
+						int width = 1, height = 1;
+
+						if (greedy) {
+							while (i + width < cells && faces[static_cast<size_t>(j) * cells + i + width]) {
+								++width;
+							}
+
+							for (; j + height < cells; ++height) {
+								const uint8_t* row = &faces[static_cast<size_t>(j + height) * cells + i];
+								int k = 0;
+								while (k < width && row[k]) {
+									++k;
+								}
+								if (k < width)
+									break;
+							}
+						}
+
+						for (int y = 0; y < height; ++y) {
+							std::fill_n(&faces[static_cast<size_t>(j + y) * cells + i], width, 0);
+						}
+
+						const unsigned int index = static_cast<unsigned int>(mesh.vertices.size());
+						const int corners[4][2] = { { i, j }, { i + width, j }, { i + width, j + height }, { i, j + height } };
+
+						for (const auto& corner : corners) {
+							float p[3];
+							p[axis] = plane;
+							p[u] = pMin[u] + corner[0] * size[u];
+							p[v] = pMin[v] + corner[1] * size[v];
+							mesh.vertices.push_back(XMFLOAT3(p[0], p[1], p[2]));
+						}
+
+						if (direction > 0) {
+							mesh.indices.insert(mesh.indices.end(), { index + 0, index + 1, index + 2, index + 0, index + 2, index + 3 });
+						}
+						else {
+							mesh.indices.insert(mesh.indices.end(), { index + 0, index + 2, index + 1, index + 0, index + 3, index + 2 });
+						}
+
+						i += width - 1;
+					}
+				}
+			}
+		}
+	}
+}
+
+void BuildLinearOctreeMesh(const LinearOctree* octree, VoxelMesh& mesh, bool greedy)
+{
+	if (octree->depth < 1 || octree->depth > VoxelGrid::MaxDepth) {
+		std::vector<BoundingBox3D> boxGeometries;
+		BuildLinearOctreeGeometry(octree, boxGeometries);
+		BuildBoxMesh(boxGeometries, mesh);
+		return;
+	}
+
+	VoxelGrid grid;
+	grid.Resize(octree->boundingBox, octree->depth);
+	FillVoxelGrid(grid, octree);
+
+	BuildVoxelGridMesh(grid, mesh, greedy);
+}
+
+void BuildBoxMesh(const std::vector<BoundingBox3D>& boxes, VoxelMesh& mesh)
+{
+	static const unsigned int boxIndices[36] = {
+		2, 0, 1, 2, 1, 3, // -x
+		6, 5, 4, 6, 7, 5, // +x
+		0, 5, 1, 0, 4, 5, // -y
+		2, 7, 6, 2, 3, 7, // +y
+		0, 6, 4, 0, 2, 6, // -z
+		1, 7, 3, 1, 5, 7, // +z
+	};
+
+	for (const auto& box : boxes) {
+		auto &Min = box.Min;
+		auto &Max = box.Max;
+		const unsigned int index = static_cast<unsigned int>(mesh.vertices.size());
+
+		mesh.vertices.insert(mesh.vertices.end(),
+			{ XMFLOAT3(Min.x, Min.y, Min.z),
+			  XMFLOAT3(Min.x, Min.y, Max.z),
+			  XMFLOAT3(Min.x, Max.y, Min.z),
+			  XMFLOAT3(Min.x, Max.y, Max.z),
+			  XMFLOAT3(Max.x, Min.y, Min.z),
+			  XMFLOAT3(Max.x, Min.y, Max.z),
+			  XMFLOAT3(Max.x, Max.y, Min.z),
+			  XMFLOAT3(Max.x, Max.y, Max.z) });
+
+		for (unsigned int boxIndex : boxIndices) {
+			mesh.indices.push_back(index + boxIndex);
+		}
+	}
+}
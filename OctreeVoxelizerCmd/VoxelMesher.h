@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+
+#include "BoundingBox3D.h"
+#include "LinearOctree.h"
+#include "VoxelGrid.h"
+
+// Surface meshes of voxel sets. Faces between two occupied cells are culled,
+// and with greedy merging the remaining faces of each slice and direction are
+// merged into maximal rectangles. Triangles wind like the box meshes, counter-
+// clockwise seen from outside; indices are zero-based.
+
+struct VoxelMesh {
+	std::vector<DirectX::XMFLOAT3> vertices;
+	std::vector<unsigned int> indices;
+};
+
+void BuildVoxelGridMesh(const VoxelGrid& grid, VoxelMesh& mesh, bool greedy = true);
+
+// Rasterizes the octree into a VoxelGrid and meshes that. Octrees deeper than
+// VoxelGrid::MaxDepth fall back to BuildBoxMesh.
+void BuildLinearOctreeMesh(const LinearOctree* octree, VoxelMesh& mesh, bool greedy = true);
+
+// Eight vertices and twelve triangles per box, nothing culled.
+void BuildBoxMesh(const std::vector<BoundingBox3D>& boxes, VoxelMesh& mesh);
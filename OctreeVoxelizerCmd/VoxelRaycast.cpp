@@ -0,0 +1,165 @@
+#include "VoxelRaycast.h"
+
+#include <algorithm>
+
+using namespace DirectX;
+
+// Stands in for a zero direction component, so a ray parallel to a slab gets
+// huge finite parameters of the right sign instead of infinities and NaNs.
+static const float MinDirection = 1e-20f;
+
+struct RayFrame {
+	uint32_t node;
+	int level;
+	uint64_t code;
+	float t0[3], t1[3], tm[3];
+	int child; // mirrored octant of the next child to visit, 8 when done
+};
+
+static int MaxAxis(const float* t)
+{
+	return t[0] >= t[1] ? (t[0] >= t[2] ? 0 : 2) : (t[1] >= t[2] ? 1 : 2);
+}
+
+static int MinAxis(const float* t)
+{
+	return t[0] <= t[1] ? (t[0] <= t[2] ? 0 : 2) : (t[1] <= t[2] ? 1 : 2);
+}
+
+// Calls visit(hit) for every complete cell the ray enters, front to back,
+// until it returns false.
+template <typename Visit>
+static void TraverseLinearOctree(const LinearOctree* octree, const XMFLOAT3& origin, const XMFLOAT3& direction, float maxDistance, Visit visit)
+{
+	if (octree->nodes.empty())
+		return;
+
+	const float* pMin = &octree->boundingBox.Min.x;
+	const float* pMax = &octree->boundingBox.Max.x;
+	const float* pOrigin = &origin.x;
+	const float* pDirection = &direction.x;
+
+	// Mirrored through the box center on every axis the ray runs backwards.
+	int mirror = 0;
+	float rootT0[3], rootT1[3];
+
+	for (int axis = 0; axis < 3; ++axis) {
+		float o = pOrigin[axis];
+		float d = pDirection[axis];
+
+		if (d < 0) {
+			o = pMin[axis] + pMax[axis] - o;
+			d = -d;
+			mirror |= 1 << axis;
+		}
+		d = std::max(d, MinDirection);
+
+		rootT0[axis] = (pMin[axis] - o) / d;
+		rootT1[axis] = (pMax[axis] - o) / d;
+	}
+
+	RayFrame stack[LinearOctree::MaxDepth + 1];
+	int top = -1;
+
+	// Visits a complete node, or pushes an inner one; false once visit stops.
+	auto enter = [&](uint32_t node, int level, uint64_t code, const float* t0, const float* t1) {
+		const int entryAxis = MaxAxis(t0);
+		const float tEnter = t0[entryAxis];
+		const float tExit = std::min(std::min(t1[0], t1[1]), t1[2]);
+
+		if (tEnter > tExit || tExit < 0 || tEnter > maxDistance)
+			return true;
+
+		if (octree->nodes[node].isCompleteSubtree) {
+			VoxelRayHit hit;
+			hit.distance = std::max(tEnter, 0.f);
+			hit.normal = XMFLOAT3(0, 0, 0);
+			if (tEnter >= 0) {
+				(&hit.normal.x)[entryAxis] = mirror & (1 << entryAxis) ? 1.f : -1.f;
+			}
+			hit.code = code;
+			hit.level = level;
+
+			return visit(hit);
+		}
+
+		RayFrame& frame = stack[++top];
+		frame.node = node;
+		frame.level = level;
+		frame.code = code;
+		frame.child = 0;
+
+		for (int axis = 0; axis < 3; ++axis) {
+			frame.t0[axis] = t0[axis];
+			frame.t1[axis] = t1[axis];
+			frame.tm[axis] = 0.5f * (t0[axis] + t1[axis]);
+
+			// The first child is on the far side of every midplane crossed before entry.
+			if (frame.tm[axis] < tEnter) {
+				frame.child |= 1 << axis;
+			}
+		}
+
+		return true;
+	};
+
+	if (!enter(0, 0, 0, rootT0, rootT1))
+		return;
+
+	while (top >= 0) {
+		RayFrame& frame = stack[top];
+
+		if (frame.child == 8) {
+			--top;
+			continue;
+		}
+
+		const int child = frame.child;
+		float t0[3], t1[3];
+
+		for (int axis = 0; axis < 3; ++axis) {
+			const bool upper = (child & (1 << axis)) != 0;
+			t0[axis] = upper ? frame.tm[axis] : frame.t0[axis];
+			t1[axis] = upper ? frame.t1[axis] : frame.tm[axis];
+		}
+
+		// The next child is across the plane this one is left through, unless
+		// that plane is the node's own far side.
+		const int exitAxis = MinAxis(t1);
+		frame.child = child & (1 << exitAxis) ? 8 : child | (1 << exitAxis);
+
+		const LinearOctreeNode& node = octree->nodes[frame.node];
+		const int octant = child ^ mirror;
+
+		if (node.childMask & (1 << octant)) {
+			const uint32_t index = node.firstChild + ChildCount(node.childMask & ((1 << octant) - 1));
+			if (!enter(index, frame.level + 1, (frame.code << 3) | octant, t0, t1))
+				return;
+		}
+	}
+}
+
+bool RaycastLinearOctree(const LinearOctree* octree, const XMFLOAT3& origin, const XMFLOAT3& direction, float maxDistance, VoxelRayHit& hit)
+{
+	bool found = false;
+
+	TraverseLinearOctree(octree, origin, direction, maxDistance, [&](const VoxelRayHit& cell) {
+		hit = cell;
+		found = true;
+		return false;
+	});
+
+	return found;
+}
+
+size_t RaycastLinearOctreeAll(const LinearOctree* octree, const XMFLOAT3& origin, const XMFLOAT3& direction, float maxDistance, std::vector<VoxelRayHit>& hits)
+{
+	const size_t first = hits.size();
+
+	TraverseLinearOctree(octree, origin, direction, maxDistance, [&](const VoxelRayHit& cell) {
+		hits.push_back(cell);
+		return true;
+	});
+
+	return hits.size() - first;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "LinearOctree.h"
+
+// Ray queries against the occupied cells of a LinearOctree, for picking with
+// gaze or hand rays. The traversal is parametric: the ray is mirrored so every
+// direction component is positive, each node's entry and exit parameters along
+// x, y and z are split at its midpoint, and children are visited front to back
+// with no box tests. Complete nodes are hit as a whole. Nothing is allocated;
+// the path from the root lives in a fixed array on the stack.
+
+struct VoxelRayHit {
+	float distance;           // ray parameter at entry, 0 if the origin is inside the cell
+	DirectX::XMFLOAT3 normal; // outward normal of the entered face, zero if the origin is inside
+	uint64_t code;            // the hit cell: a leaf or complete node
+	int level;
+};
+
+// Distances are in units of direction's length, world units if it is
+// normalized. Only hits at distance <= maxDistance count.
+bool RaycastLinearOctree(const LinearOctree* octree, const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float maxDistance, VoxelRayHit& hit);
+
+// Appends every cell the ray enters, nearest first, and returns how many.
+size_t RaycastLinearOctreeAll(const LinearOctree* octree, const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float maxDistance, std::vector<VoxelRayHit>& hits);